@@ -0,0 +1,5 @@
+fn main() {
+    cc::Build::new().file("workloads.c").opt_level(2).compile("workloads");
+
+    println!("cargo:rerun-if-changed=workloads.c");
+}
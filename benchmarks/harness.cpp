@@ -0,0 +1,247 @@
+// Measures how much Baleen slows down the workloads in this directory. Every
+// workload runs natively and under every Baleen mode, and the fastest of a
+// few runs is kept. For every pair it records the wall time, the slowdown
+// over the native run, the peak memory and the memory Baleen added on top of
+// the native run, and the instrumentation time: how much longer Baleen takes
+// to get to main and back out when the workload does no work (scale 0).
+//
+// Build the workloads and find their foreign functions first:
+//
+//     cargo build --release
+//     bfff --output foreign-functions.txt
+//
+// Usage: baleen-bench [--repeat N] [--workloads A,B] [--modes A,B] [--output FILE]
+//
+// Pin is taken from $PIN (or the PATH) and the tool from $BALEEN, like the
+// alias that build.sh prints.
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::ofstream;
+using std::ostream;
+using std::setprecision;
+using std::string;
+using std::vector;
+
+static const char* WORKLOADS[] = {
+	"small-allocs", "realloc-vectors", "shared-buffers", "callbacks", "long-loop"
+};
+
+struct Mode {
+	string name;
+	vector<string> knobs;
+};
+
+// Native is not a Baleen mode, it is the baseline of every workload.
+static const char* NATIVE = "native";
+
+static const vector<Mode> MODES = {
+	{ "default", {} },
+	{ "no-profile", { "-profile", "0" } },
+	{ "heavy-hitters", { "-heavy_hitters", "32" } },
+	{ "csv", { "-format", "csv" } },
+	{ "live", { "-live", "100" } },
+};
+
+struct Measurement {
+	double seconds;
+
+	// Peak resident memory, in KiB.
+	long memory;
+};
+
+static double Now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Runs `command` with its output discarded. Returns false if it failed.
+static bool Measure(const vector<string>& command, Measurement& measurement) {
+	vector<char*> argv;
+
+	for (const string& argument : command) {
+		argv.push_back(const_cast<char*>(argument.c_str()));
+	}
+
+	argv.push_back(nullptr);
+
+	double start = Now();
+	pid_t pid = fork();
+
+	if (pid < 0) return false;
+
+	if (pid == 0) {
+		if (!freopen("/dev/null", "w", stdout)) _exit(127);
+		execvp(argv[0], argv.data());
+		_exit(127);
+	}
+
+	int status;
+	struct rusage usage;
+
+	if (wait4(pid, &status, 0, &usage) != pid) return false;
+
+	measurement.seconds = Now() - start;
+	measurement.memory = usage.ru_maxrss;
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Runs `command` `repeat` times and keeps the fastest run.
+static bool Best(const vector<string>& command, int repeat, Measurement& best) {
+	for (int i = 0; i < repeat; i++) {
+		Measurement measurement;
+
+		if (!Measure(command, measurement)) {
+			cerr << "Failed to run '" << command.back() << "'" << endl;
+			return false;
+		}
+
+		if (i == 0 || measurement.seconds < best.seconds) {
+			best = measurement;
+		}
+	}
+
+	return true;
+}
+
+static vector<string> Split(const string& list) {
+	vector<string> items;
+	std::istringstream stream(list);
+	string item;
+
+	while (std::getline(stream, item, ',')) {
+		items.push_back(item);
+	}
+
+	return items;
+}
+
+static void Row(ostream& stream, const string& workload, const string& mode, const Measurement& run, const Measurement& native, const Measurement& startup, const Measurement& nativeStartup) {
+	stream << workload << ", " << mode << ", "
+		<< run.seconds << ", "
+		<< run.seconds / native.seconds << ", "
+		<< run.memory << ", "
+		<< run.memory - native.memory << ", "
+		<< std::max(0.0, startup.seconds - nativeStartup.seconds) << endl;
+}
+
+static int Usage(const char* program) {
+	cerr << "Usage: " << program << " [--repeat N] [--workloads A,B] [--modes A,B] [--output FILE]" << endl;
+	return 2;
+}
+
+int main(int argc, char *argv[]) {
+	int repeat = 3;
+	string output = "results.csv";
+	vector<string> workloads(std::begin(WORKLOADS), std::end(WORKLOADS));
+	vector<Mode> modes = MODES;
+
+	for (int i = 1; i < argc; i++) {
+		string option = argv[i];
+
+		if (i + 1 >= argc) return Usage(argv[0]);
+
+		string value = argv[++i];
+
+		if (option == "--repeat") {
+			repeat = std::max(1, std::atoi(value.c_str()));
+		} else if (option == "--workloads") {
+			workloads = Split(value);
+		} else if (option == "--modes") {
+			vector<string> names = Split(value);
+
+			modes.clear();
+
+			for (const Mode& mode : MODES) {
+				if (std::find(names.begin(), names.end(), mode.name) != names.end()) {
+					modes.push_back(mode);
+				}
+			}
+		} else if (option == "--output") {
+			output = value;
+		} else {
+			return Usage(argv[0]);
+		}
+	}
+
+	const char* pin = getenv("PIN") ? getenv("PIN") : "pin";
+	const char* tool = getenv("BALEEN");
+
+	if (tool == nullptr) {
+		cerr << "Set $BALEEN to the path of baleen.so" << endl;
+		return 2;
+	}
+
+	ofstream results(output);
+
+	const char* header = "Workload, Mode, Time (s), Slowdown, Peak Memory (KiB), Tool Memory (KiB), Instrumentation (s)";
+
+	cout << header << endl;
+	results << header << endl;
+
+	cout << fixed << setprecision(3);
+	results << fixed << setprecision(3);
+
+	int failures = 0;
+
+	for (const string& workload : workloads) {
+		string binary = "target/release/" + workload;
+
+		Measurement native, nativeStartup;
+
+		if (!Best({ binary }, repeat, native) || !Best({ binary, "0" }, repeat, nativeStartup)) {
+			failures += 1;
+			continue;
+		}
+
+		Row(cout, workload, NATIVE, native, native, nativeStartup, nativeStartup);
+		Row(results, workload, NATIVE, native, native, nativeStartup, nativeStartup);
+
+		for (const Mode& mode : modes) {
+			// Every run gets its own output directory, so runs never share files
+			vector<string> command = {
+				pin, "-t", tool,
+				"-output", "bench-output/" + workload + "-" + mode.name,
+				"-foreign_functions", "foreign-functions.txt",
+			};
+
+			command.insert(command.end(), mode.knobs.begin(), mode.knobs.end());
+			command.push_back("--");
+			command.push_back(binary);
+
+			vector<string> startupCommand = command;
+			startupCommand.push_back("0");
+
+			Measurement run, startup;
+
+			if (!Best(command, repeat, run) || !Best(startupCommand, repeat, startup)) {
+				failures += 1;
+				continue;
+			}
+
+			Row(cout, workload, mode.name, run, native, startup, nativeStartup);
+			Row(results, workload, mode.name, run, native, startup, nativeStartup);
+		}
+	}
+
+	return failures > 0 ? 1 : 0;
+}
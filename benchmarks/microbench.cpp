@@ -0,0 +1,325 @@
+// Replays allocation and access streams against the Pin-free core (see
+// include/platform.h) and reports the cost of every operation, so changes to
+// the registry and the trackers can be measured without running Pin.
+//
+// The synthetic streams are:
+//
+//     sequential   objects laid out back to back, accessed in address order
+//     random       objects at scattered addresses, accessed in random order
+//     fragmented   small objects with gaps, constantly freed and reallocated
+//     threads      random accesses from 1, 2, 4 and 8 threads at once
+//
+// A recorded stream is a text file with one event per line:
+//
+//     a <address> <size>   allocation (malloc returned <address>)
+//     f <address>          free
+//     r <address>          read
+//     w <address>          write
+//
+// Addresses are hexadecimal, sizes decimal.
+//
+// Usage: baleen-microbench [--objects N] [--accesses N] [--replay FILE]
+
+#include "allocation.h"
+#include "language.h"
+#include "logger.h"
+#include "object.h"
+#include "registry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+// Where the synthetic heaps start.
+static const ADDRINT HEAP = 0x10000000;
+
+struct Event {
+	char kind;
+	ADDRINT addr;
+	USIZE size;
+};
+
+static double Nanoseconds(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void Print(const string& stream, const string& operation, UINT32 threads, UINT64 count, double nanoseconds) {
+	cout << stream << ", " << operation << ", " << threads << ", " << count << ", "
+		<< (count == 0 ? 0.0 : nanoseconds / count) << endl;
+}
+
+// The starting addresses of `count` objects of `size` bytes.
+static vector<ADDRINT> Layout(USIZE count, USIZE size, USIZE gap) {
+	vector<ADDRINT> starts;
+
+	for (USIZE i = 0; i < count; i++) {
+		starts.push_back(HEAP + i * (size + gap));
+	}
+
+	return starts;
+}
+
+// Looks up `accesses` addresses in a registry holding `starts`, inserted in
+// the given order.
+static void BenchmarkRegistry(const string& stream, const vector<ADDRINT>& starts, USIZE size, const vector<ADDRINT>& accesses) {
+	Registry registry;
+
+	auto start = Clock::now();
+
+	for (ADDRINT addr : starts) {
+		Node *replaced;
+		registry.insert(addr, size, std::to_string(addr), Language::RUST, &replaced);
+		delete replaced;
+	}
+
+	auto inserted = Clock::now();
+
+	UINT64 found = 0;
+
+	for (ADDRINT addr : accesses) {
+		found += registry.find(addr) != nullptr;
+	}
+
+	auto end = Clock::now();
+
+	Print(stream, "registry insert", 1, starts.size(), Nanoseconds(start, inserted));
+	Print(stream, "registry find", 1, accesses.size(), Nanoseconds(inserted, end));
+
+	if (found != accesses.size()) {
+		cerr << stream << ": " << accesses.size() - found << " accesses missed their object" << endl;
+	}
+}
+
+// Records `accesses` against an object tracker holding `starts`, alternating
+// reads and writes.
+static void BenchmarkObjects(const string& stream, const vector<ADDRINT>& starts, USIZE size, const vector<ADDRINT>& accesses, Logger& logger) {
+	ObjectTracker objectTracker(logger);
+
+	for (ADDRINT addr : starts) {
+		objectTracker.RegisterObject(0, addr, size, Language::RUST, 0, 0);
+	}
+
+	auto start = Clock::now();
+
+	for (USIZE i = 0; i < accesses.size(); i++) {
+		if (i % 2 == 0) {
+			objectTracker.RecordRead(0, accesses[i], sizeof(ADDRINT), Language::RUST, UNKNOWN_ROUTINE);
+		} else {
+			objectTracker.RecordWrite(0, accesses[i], sizeof(ADDRINT), Language::C, UNKNOWN_ROUTINE);
+		}
+	}
+
+	auto end = Clock::now();
+
+	Print(stream, "record access", 1, accesses.size(), Nanoseconds(start, end));
+}
+
+// Replays `events` through the allocation and object trackers, as the
+// analysis routines of the Pin tool would.
+static void Replay(const string& stream, const vector<Event>& events, Logger& logger) {
+	AllocationTracker allocationTracker(logger);
+	allocationTracker.Initialize();
+	ObjectTracker objectTracker(logger);
+
+	UINT64 allocations = 0, frees = 0, accesses = 0;
+	double allocationTime = 0, freeTime = 0, accessTime = 0;
+
+	for (const Event& event : events) {
+		auto start = Clock::now();
+
+		switch (event.kind) {
+		case 'a':
+			allocationTracker.BeforeMalloc(0, event.size, Language::RUST, 0);
+			allocationTracker.AfterMalloc(0, event.addr, Language::RUST, objectTracker);
+			allocationTime += Nanoseconds(start, Clock::now());
+			allocations += 1;
+			break;
+		case 'f':
+			allocationTracker.BeforeFree(0, event.addr, objectTracker);
+			freeTime += Nanoseconds(start, Clock::now());
+			frees += 1;
+			break;
+		case 'r':
+			objectTracker.RecordRead(0, event.addr, sizeof(ADDRINT), Language::RUST, UNKNOWN_ROUTINE);
+			accessTime += Nanoseconds(start, Clock::now());
+			accesses += 1;
+			break;
+		case 'w':
+			objectTracker.RecordWrite(0, event.addr, sizeof(ADDRINT), Language::RUST, UNKNOWN_ROUTINE);
+			accessTime += Nanoseconds(start, Clock::now());
+			accesses += 1;
+			break;
+		}
+	}
+
+	Print(stream, "allocate", 1, allocations, allocationTime);
+	Print(stream, "free", 1, frees, freeTime);
+	Print(stream, "record access", 1, accesses, accessTime);
+}
+
+// Small objects with gaps between them. Every step frees a random object,
+// allocates it again and accesses a few random objects.
+static vector<Event> Fragmented(USIZE objects, USIZE accesses, std::mt19937_64& random) {
+	const USIZE size = 24;
+	vector<ADDRINT> starts = Layout(objects, size, 40);
+	vector<Event> events;
+
+	for (ADDRINT addr : starts) {
+		events.push_back({ 'a', addr, size });
+	}
+
+	for (USIZE i = 0; i < accesses / 4; i++) {
+		ADDRINT churned = starts[random() % starts.size()];
+
+		events.push_back({ 'f', churned, 0 });
+		events.push_back({ 'a', churned, size });
+
+		for (int j = 0; j < 4; j++) {
+			ADDRINT addr = starts[random() % starts.size()] + random() % size;
+			events.push_back({ j % 2 == 0 ? 'r' : 'w', addr, 0 });
+		}
+	}
+
+	return events;
+}
+
+// Records the same accesses from `threads` threads at once.
+static void BenchmarkThreads(const vector<ADDRINT>& starts, USIZE size, const vector<ADDRINT>& accesses, Logger& logger) {
+	for (UINT32 threads : { 1, 2, 4, 8 }) {
+		ObjectTracker objectTracker(logger);
+
+		for (ADDRINT addr : starts) {
+			objectTracker.RegisterObject(0, addr, size, Language::RUST, 0, 0);
+		}
+
+		vector<std::thread> workers;
+		auto start = Clock::now();
+
+		for (UINT32 tid = 0; tid < threads; tid++) {
+			workers.emplace_back([&, tid]() {
+				for (ADDRINT addr : accesses) {
+					objectTracker.RecordRead(tid, addr, sizeof(ADDRINT), Language::RUST, UNKNOWN_ROUTINE);
+				}
+			});
+		}
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		auto end = Clock::now();
+
+		// Wall time per access, so perfect scaling halves it with every doubling
+		Print("threads", "record access", threads, accesses.size() * threads, Nanoseconds(start, end));
+	}
+}
+
+static bool ReadStream(const string& path, vector<Event>& events) {
+	std::ifstream input(path);
+
+	if (!input.is_open()) return false;
+
+	string line;
+
+	while (std::getline(input, line)) {
+		std::istringstream fields(line);
+		Event event = { 0, 0, 0 };
+
+		fields >> event.kind >> std::hex >> event.addr >> std::dec >> event.size;
+
+		if (event.kind == 'a' || event.kind == 'f' || event.kind == 'r' || event.kind == 'w') {
+			events.push_back(event);
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	USIZE objects = 4096;
+	USIZE accesses = 200000;
+	string replay;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		string option = argv[i];
+
+		if (option == "--objects") {
+			objects = std::max(1UL, std::strtoul(argv[i + 1], nullptr, 10));
+		} else if (option == "--accesses") {
+			accesses = std::strtoul(argv[i + 1], nullptr, 10);
+		} else if (option == "--replay") {
+			replay = argv[i + 1];
+		} else {
+			cerr << "Usage: " << argv[0] << " [--objects N] [--accesses N] [--replay FILE]" << endl;
+			return 2;
+		}
+	}
+
+	// The logs are never opened, so logging costs as little as it can
+	Logger logger;
+	std::mt19937_64 random(42);
+
+	cout << fixed << setprecision(1);
+	cout << "Stream, Operation, Threads, Operations, ns/op" << endl;
+
+	const USIZE size = 64;
+
+	// Sequential: back to back, inserted and accessed in address order
+	vector<ADDRINT> sequential = Layout(objects, size, 0);
+	vector<ADDRINT> walk;
+
+	for (USIZE i = 0; i < accesses; i++) {
+		walk.push_back(sequential[(i / 8) % objects] + (i % 8) * 8);
+	}
+
+	BenchmarkRegistry("sequential", sequential, size, walk);
+	BenchmarkObjects("sequential", sequential, size, walk, logger);
+
+	// Random: scattered, inserted and accessed in random order
+	vector<ADDRINT> scattered = Layout(objects, size, 4096);
+	std::shuffle(scattered.begin(), scattered.end(), random);
+
+	vector<ADDRINT> jumps;
+
+	for (USIZE i = 0; i < accesses; i++) {
+		jumps.push_back(scattered[random() % objects] + random() % size);
+	}
+
+	BenchmarkRegistry("random", scattered, size, jumps);
+	BenchmarkObjects("random", scattered, size, jumps, logger);
+
+	Replay("fragmented", Fragmented(objects, accesses, random), logger);
+
+	BenchmarkThreads(scattered, size, jumps, logger);
+
+	if (!replay.empty()) {
+		vector<Event> events;
+
+		if (!ReadStream(replay, events)) {
+			cerr << "Cannot read " << replay << endl;
+			return 1;
+		}
+
+		Replay(replay, events, logger);
+	}
+
+	return 0;
+}
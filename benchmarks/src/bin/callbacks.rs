@@ -0,0 +1,20 @@
+//! C calling back into Rust for every element, so the language changes twice
+//! per element.
+
+use benchmarks::*;
+
+extern "C" fn square(value: u64) -> u64 {
+    value.wrapping_mul(value)
+}
+
+fn main() {
+    let scale = scale(500);
+    let values: Vec<u64> = (0..10_000).collect();
+    let mut checksum = 0;
+
+    for _ in 0..scale {
+        checksum ^= unsafe { c_for_each(values.as_ptr(), values.len(), square) };
+    }
+
+    finish("callbacks", checksum);
+}
@@ -0,0 +1,27 @@
+//! A long-running loop over a fixed working set, mostly in Rust with a C call
+//! every iteration.
+
+use benchmarks::*;
+
+const LENGTH: usize = 1 << 14;
+
+fn main() {
+    let scale = scale(5_000);
+    let mut values = vec![1u64; LENGTH];
+    let mut copy = vec![0u64; LENGTH];
+
+    for i in 0..scale {
+        for value in values.iter_mut() {
+            *value = value.rotate_left(7) ^ i;
+        }
+
+        unsafe {
+            c_mix(values.as_mut_ptr(), values.len(), i);
+            c_copy(copy.as_mut_ptr(), values.as_ptr(), values.len());
+        }
+    }
+
+    let checksum = copy.iter().fold(0u64, |sum, value| sum.wrapping_add(*value));
+
+    finish("long-loop", checksum);
+}
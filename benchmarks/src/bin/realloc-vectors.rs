@@ -0,0 +1,22 @@
+//! Large vectors grown one element at a time, so they are reallocated and
+//! moved over and over.
+
+use benchmarks::*;
+
+fn main() {
+    let scale = scale(20);
+    let mut checksum = 0;
+
+    for _ in 0..scale {
+        let mut values = Vec::new();
+
+        for i in 0..1_000_000u64 {
+            values.push(i);
+        }
+
+        checksum += unsafe { c_sum(values.as_ptr(), values.len()) };
+        checksum += unsafe { c_grow(1_000_000) };
+    }
+
+    finish("realloc-vectors", checksum);
+}
@@ -0,0 +1,27 @@
+//! Threads updating disjoint slices of one buffer from C, and reading all of
+//! it from Rust.
+
+use benchmarks::*;
+use std::thread;
+
+const THREADS: usize = 4;
+const LENGTH: usize = 1 << 16;
+
+fn main() {
+    let scale = scale(200);
+    let mut buffer = vec![0u64; THREADS * LENGTH];
+
+    for round in 0..scale {
+        thread::scope(|scope| {
+            for slice in buffer.chunks_mut(LENGTH) {
+                scope.spawn(move || unsafe {
+                    c_update(slice.as_mut_ptr(), slice.len(), round + 1);
+                });
+            }
+        });
+    }
+
+    let checksum = buffer.iter().fold(0u64, |sum, value| sum.wrapping_add(*value));
+
+    finish("shared-buffers", checksum);
+}
@@ -0,0 +1,21 @@
+//! Many small, short-lived allocations in both languages.
+
+use benchmarks::*;
+
+fn main() {
+    let scale = scale(200_000);
+    let mut checksum = 0;
+
+    for i in 0..scale / 100 {
+        // Small Rust allocations handed to C
+        let values: Vec<u64> = (0..(i % 16) + 1).collect();
+        checksum += unsafe { c_sum(values.as_ptr(), values.len()) };
+
+        let boxed = Box::new(i);
+        checksum += *boxed;
+
+        checksum += unsafe { c_small_allocs(100) };
+    }
+
+    finish("small-allocs", checksum);
+}
@@ -0,0 +1,27 @@
+//! Workloads that stress different paths of Baleen. Every workload is a
+//! binary in `src/bin` that takes a scale as its only argument, so
+//! `baleen-bench` (`harness.cpp`) can run it natively and under Baleen. A scale of 0 exits right away, which
+//! measures how long Baleen takes to instrument the program.
+
+unsafe extern "C" {
+    pub fn c_small_allocs(count: u64) -> u64;
+    pub fn c_sum(values: *const u64, count: usize) -> u64;
+    pub fn c_grow(count: usize) -> u64;
+    pub fn c_update(values: *mut u64, count: usize, delta: u64);
+    pub fn c_for_each(values: *const u64, count: usize, callback: extern "C" fn(u64) -> u64) -> u64;
+    pub fn c_mix(values: *mut u64, count: usize, seed: u64);
+    pub fn c_copy(dst: *mut u64, src: *const u64, count: usize);
+}
+
+/// Reads the scale from the command line.
+pub fn scale(default: u64) -> u64 {
+    std::env::args()
+        .nth(1)
+        .map(|arg| arg.parse().expect("the scale must be a number"))
+        .unwrap_or(default)
+}
+
+/// Prints the result, so the work can't be optimized away.
+pub fn finish(name: &str, checksum: u64) {
+    println!("{name}: {checksum}");
+}
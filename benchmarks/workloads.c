@@ -0,0 +1,93 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Allocates `count` small blocks of varying sizes, touches them and frees
+// them again, keeping a few alive at a time.
+uint64_t c_small_allocs(uint64_t count) {
+	void *slots[64] = { 0 };
+	uint64_t checksum = 0;
+
+	for (uint64_t i = 0; i < count; i++) {
+		size_t slot = i % 64;
+
+		free(slots[slot]);
+
+		size_t size = 8 + (i * 7) % 120;
+		unsigned char *block = malloc(size);
+
+		block[0] = (unsigned char) i;
+		block[size - 1] = (unsigned char) (i >> 8);
+		checksum += block[0] + block[size - 1];
+
+		slots[slot] = block;
+	}
+
+	for (size_t slot = 0; slot < 64; slot++) {
+		free(slots[slot]);
+	}
+
+	return checksum;
+}
+
+// Sums a buffer allocated by Rust.
+uint64_t c_sum(const uint64_t *values, size_t count) {
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		sum += values[i];
+	}
+
+	return sum;
+}
+
+// Grows a buffer one element at a time with realloc, doubling its capacity.
+uint64_t c_grow(size_t count) {
+	size_t capacity = 1;
+	uint64_t *values = malloc(capacity * sizeof(uint64_t));
+
+	for (size_t i = 0; i < count; i++) {
+		if (i == capacity) {
+			capacity *= 2;
+			values = realloc(values, capacity * sizeof(uint64_t));
+		}
+
+		values[i] = i;
+	}
+
+	uint64_t last = values[count - 1];
+	free(values);
+
+	return last;
+}
+
+// Adds `delta` to every element of a slice of a buffer shared between threads.
+void c_update(uint64_t *values, size_t count, uint64_t delta) {
+	for (size_t i = 0; i < count; i++) {
+		values[i] += delta;
+	}
+}
+
+// Calls back into Rust for every element.
+uint64_t c_for_each(const uint64_t *values, size_t count, uint64_t (*callback)(uint64_t)) {
+	uint64_t result = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		result ^= callback(values[i]);
+	}
+
+	return result;
+}
+
+// One step of a long computation: mixes the buffer in place.
+void c_mix(uint64_t *values, size_t count, uint64_t seed) {
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		values[i] ^= seed >> 17;
+	}
+}
+
+// Copies between two buffers, like the bulk transfers at FFI boundaries.
+void c_copy(uint64_t *dst, const uint64_t *src, size_t count) {
+	memcpy(dst, src, count * sizeof(uint64_t));
+}
@@ -2,10 +2,11 @@
 
 mkdir -p obj-intel64
 make obj-intel64/baleen.so TARGET=intel64
+make utilities TARGET=intel64
 
 PIN_DIR=$(dirname $(dirname $(dirname $(pwd))))
 
 echo "\nBuild complete! Add the commands below to your shell configuration file.\n"
-echo "export PATH=\$PATH:$PIN_DIR"
+echo "export PATH=\$PATH:$PIN_DIR:$(pwd)/obj-intel64"
 echo "export BALEEN=$(pwd)/obj-intel64/baleen.so"
 echo "alias baleen='pin -t \$BALEEN --'"
\ No newline at end of file
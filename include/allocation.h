@@ -1,46 +1,151 @@
 #ifndef ALLOCATION_H
 #define ALLOCATION_H
 
-#include "pin.H"
+#include "platform.h"
 
 #include "language.h"
 #include "object.h"
+#include "telemetry.h"
 
 using std::ofstream;
 using std::map;
 using std::pair;
 using std::get;
 using std::tuple;
+using std::vector;
+
+// A heap block that has not been freed yet.
+struct Block {
+	// The size of the block.
+	USIZE size;
+
+	// The language that allocated the block.
+	Language lang;
+
+	// The thread that allocated the block.
+	THREADID owner;
+
+	// When the block was allocated, in nanoseconds since Baleen started.
+	UINT64 allocated;
+};
+
+enum class AllocationCall {
+	MALLOC,
+	POSIX_MEMALIGN,
+	REALLOC
+};
+
+// An allocator call that has been entered but has not returned yet.
+struct PendingCall {
+	AllocationCall call;
+
+	// The number of the call among the calls of its thread, for the logs.
+	UINT64 id;
+
+	// The block passed to realloc, or where posix_memalign stores the block.
+	ADDRINT addr;
+
+	USIZE size;
+	ADDRINT site;
+	Language lang;
+};
+
+// The allocation state of a single thread. It is only touched by its own
+// thread, so the entry hooks of the allocators run without taking a lock.
+struct AllocationThread {
+	THREADID tid;
+
+	// Calls that have been entered but have not returned, innermost last.
+	// It is a stack so an allocator that calls another one (e.g. a realloc
+	// that mallocs a new block) does not lose the outer call.
+	vector<PendingCall> pending;
+
+	UINT64 calls;
+
+	// The bytes allocated by this thread in each language.
+	UINT64 allocated[LANGUAGES];
+};
 
 class AllocationTracker {
 private:
 	PIN_LOCK lock;
+	LockStats locks;
+	TLS_KEY key;
 	Logger& logger;
 
-	map<Language, UINT64> allocations;
+	// The state of every thread that ever allocated, merged when reporting.
+	vector<AllocationThread*> threads;
+
+	// Maps the starting address of every live block to its metadata.
+	map<ADDRINT, Block> blocks;
+
+	// The bytes currently allocated by each language, and the most it ever had.
+	map<Language, UINT64> live;
+	map<Language, UINT64> peak;
+
+	// Maps every language and size class to a histogram of block lifetimes.
+	map<Language, map<UINT32, map<UINT32, UINT64>>> lifetimes;
+
+	// When Baleen started, when the timeline was last sampled, and how often
+	// it should be sampled (all in nanoseconds).
+	UINT64 start;
+	UINT64 lastSample;
+	UINT64 interval;
+
+	// The state of thread `tid`, created the first time it allocates.
+	AllocationThread* Thread(THREADID tid);
+
+	VOID Push(THREADID tid, AllocationCall call, ADDRINT addr, USIZE size, ADDRINT site, Language lang);
+
+	// Pops the innermost pending call of kind `call`. Calls above it never
+	// returned (e.g. a hook that was left with longjmp) and are dropped.
+	BOOL Pop(AllocationThread* thread, AllocationCall call, PendingCall& pending);
 
-	map<THREADID, pair<UINT64, USIZE>> pendingMalloc;
-	map<THREADID, tuple<UINT64, ADDRINT, USIZE>> pendingPosixMemalign;
-	map<THREADID, tuple<UINT64, ADDRINT, USIZE>> pendingRealloc;
+	// Sums the bytes allocated by every thread in each language.
+	VOID Allocated(UINT64 allocated[]);
 
-	map<THREADID, map<string, UINT64>> counter;
-	
-	VOID Allocate(THREADID tid, UINT64 bytes, Language lang);
+	VOID Allocate(AllocationThread* thread, ADDRINT addr, UINT64 bytes, Language lang);
+	VOID Resize(THREADID tid, ADDRINT oldAddr, ADDRINT newAddr, UINT64 bytes);
+	VOID Deallocate(THREADID tid, ADDRINT addr);
+
+	VOID Sample(UINT64 now);
 
 public:
 	AllocationTracker(Logger& l);
 
-	VOID BeforeMalloc(THREADID tid, UINT64 bytes, Language lang);
+	// Creates the thread-local storage key, after Pin is initialized.
+	VOID Initialize();
+
+	VOID SetTimelineInterval(UINT64 milliseconds);
+
+	// Writes the header of the timeline, once the log files are open.
+	VOID StartTimeline();
+
+	// Resets the tracker in a forked child (see ForkChild in baleen.cpp).
+	VOID AfterFork(THREADID tid);
+
+	VOID BeforeMalloc(THREADID tid, UINT64 bytes, Language lang, ADDRINT site);
 	VOID AfterMalloc(THREADID tid, ADDRINT returned, Language lang, ObjectTracker& objectTracker);
 
-	VOID BeforePosixMemalign(THREADID tid, ADDRINT memptr_addr, USIZE alignment, USIZE size, Language lang);
+	VOID BeforePosixMemalign(THREADID tid, ADDRINT memptr_addr, USIZE alignment, USIZE size, Language lang, ADDRINT site);
 	VOID AfterPosixMemalign(THREADID tid, ADDRINT memptr_addr, INT32 result, Language lang, ObjectTracker& objectTracker);
 
-	VOID BeforeRealloc(THREADID tid, ADDRINT oldAddr, USIZE size, Language lang);
+	VOID BeforeRealloc(THREADID tid, ADDRINT oldAddr, USIZE size, Language lang, ADDRINT site);
 	VOID AfterRealloc(THREADID tid, ADDRINT newAddr, ObjectTracker& objectTracker);
 
 	VOID BeforeFree(THREADID tid, ADDRINT newAddr, ObjectTracker& objectTracker);
 
+	// How often the lock was taken (see Telemetry).
+	LockStats& Locks() {
+		return locks;
+	}
+
+	// Whether thread `tid` is inside malloc, realloc or posix_memalign.
+	BOOL InAllocator(THREADID tid);
+
+	// Copies the allocated, live and peak bytes of every language.
+	VOID Snapshot(THREADID tid, UINT64 allocated[], UINT64 current[], UINT64 highest[]);
+
 	VOID Report(ofstream& stream);
 };
 
@@ -0,0 +1,62 @@
+#ifndef ATTACH_H
+#define ATTACH_H
+
+#include "pin.H"
+
+#include "language.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::ofstream;
+using std::string;
+using std::vector;
+
+// A memory region that already existed when Baleen attached.
+struct Region {
+	ADDRINT start;
+	ADDRINT end;
+	string name;
+};
+
+// Keeps track of the memory a process had before Baleen attached to it.
+// Objects allocated before attaching cannot be recovered from the heap, so
+// the regions that held them are reported as untracked instead, along with
+// the accesses made to them.
+class AttachTracker {
+private:
+	PIN_LOCK lock;
+
+	BOOL attached;
+
+	// Heap and anonymous regions at attach time, without thread stacks,
+	// sorted by address.
+	vector<Region> regions;
+
+	// Accesses to those regions, indexed by the language making the access.
+	UINT64 reads[LANGUAGES];
+	UINT64 writes[LANGUAGES];
+
+	BOOL Contains(ADDRINT addr);
+
+public:
+	AttachTracker();
+
+	// Records the regions of the current process from /proc/self/maps.
+	VOID Snapshot();
+
+	// Resets the tracker in a forked child (see ForkChild in baleen.cpp).
+	VOID AfterFork(THREADID tid);
+
+	BOOL Attached() {
+		return attached;
+	}
+
+	VOID RecordRead(THREADID tid, ADDRINT addr, Language lang);
+	VOID RecordWrite(THREADID tid, ADDRINT addr, Language lang);
+
+	VOID Report(ofstream& stream);
+};
+
+#endif // ATTACH_H
@@ -0,0 +1,81 @@
+#ifndef COPY_H
+#define COPY_H
+
+#include "pin.H"
+
+#include "language.h"
+#include "object.h"
+#include "logger.h"
+#include "routine.h"
+#include "telemetry.h"
+
+#include <set>
+#include <tuple>
+
+using std::ofstream;
+using std::map;
+using std::set;
+using std::string;
+using std::tuple;
+
+enum class CopyKind {
+	MEMCPY,
+	MEMMOVE,
+	MEMSET
+};
+
+string CopyKindToString(CopyKind kind);
+
+// Identifies a copy by its kind, source object, destination object, the
+// languages that allocated them and the call site.
+typedef tuple<CopyKind, string, string, string, string, ADDRINT> CopyKey;
+
+struct CopyStats {
+	UINT64 calls;
+	UINT64 bytes;
+};
+
+class CopyTracker {
+private:
+	PIN_LOCK lock;
+	LockStats locks;
+	Logger& logger;
+
+	// Starting addresses of the routines that implement a copy.
+	set<ADDRINT> routines;
+
+	// Maps every copy to its call and byte counts.
+	map<CopyKey, CopyStats> copies;
+
+	// The arguments of the checked copy (e.g. '__memcpy_chk') every thread
+	// made last, whose call to the real routine is not counted again.
+	map<THREADID, tuple<ADDRINT, ADDRINT, USIZE>> checked;
+
+	// Maps every call site to the ID of the routine it lives in.
+	map<ADDRINT, UINT32> sites;
+
+	UINT32 SiteRoutine(ADDRINT site, RoutineTable& routines);
+
+public:
+	CopyTracker(Logger& l);
+
+	// Resets the tracker in a forked child (see ForkChild in baleen.cpp).
+	VOID AfterFork(THREADID tid);
+
+	// How often the lock was taken (see Telemetry).
+	LockStats& Locks() {
+		return locks;
+	}
+
+	VOID AddRoutine(ADDRINT addr);
+
+	BOOL IsRoutine(ADDRINT addr);
+
+	// Records a copy. `isChecked` is set for the checked variants, which
+	// call another copy routine with the same arguments.
+	VOID Copy(THREADID tid, ADDRINT site, CopyKind kind, ADDRINT dst, ADDRINT src, USIZE bytes, BOOL isChecked, Language lang, ObjectTracker& objectTracker, RoutineTable& routines);
+
+	VOID Report(ofstream& stream, RoutineTable& routines);
+};
+
+#endif // COPY_H
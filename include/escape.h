@@ -0,0 +1,60 @@
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include "pin.H"
+
+#include "language.h"
+#include "object.h"
+#include "logger.h"
+#include "routine.h"
+#include "telemetry.h"
+
+#include <tuple>
+
+using std::ofstream;
+using std::map;
+using std::string;
+using std::tuple;
+
+// Identifies an escape by the object holding the pointer, the object it
+// points into, the languages that allocated them, the language that stored
+// the pointer and the store instruction.
+typedef tuple<string, string, Language, Language, Language, ADDRINT> EscapeKey;
+
+struct EscapeStats {
+	UINT64 stores;
+
+	// The ID of the routine the store instruction lives in.
+	UINT32 routine;
+};
+
+// Records pointers to objects of one language that are stored into objects
+// of the other language, the edges of the cross-language points-to graph.
+class EscapeTracker {
+private:
+	PIN_LOCK lock;
+	LockStats locks;
+	Logger& logger;
+
+	// Maps every escape to its store count.
+	map<EscapeKey, EscapeStats> escapes;
+
+public:
+	EscapeTracker(Logger& l);
+
+	// Resets the tracker in a forked child (see ForkChild in baleen.cpp).
+	VOID AfterFork(THREADID tid);
+
+	// How often the lock was taken (see Telemetry).
+	LockStats& Locks() {
+		return locks;
+	}
+
+	// Records the store of `value` to `addr`, if both resolve to objects
+	// allocated by different languages.
+	VOID Store(THREADID tid, ADDRINT site, ADDRINT addr, ADDRINT value, Language lang, UINT32 routine, ObjectTracker& objectTracker);
+
+	VOID Report(ofstream& stream, RoutineTable& routines);
+};
+
+#endif // ESCAPE_H
@@ -0,0 +1,48 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include "pin.H"
+
+#include "live.h"
+#include "allocation.h"
+#include "object.h"
+#include "language.h"
+
+#include <string>
+
+using std::string;
+
+// Publishes aggregate counters into a shared-memory segment (see live.h), so
+// they can be watched while the program runs.
+class LiveExporter {
+private:
+	LiveCounters* counters;
+	string path;
+
+	// When Baleen started, and the transition count at the previous update.
+	UINT64 start;
+	UINT64 lastUpdate;
+	UINT64 lastTransitions;
+
+public:
+	LiveExporter();
+
+	// Creates the segment for this process.
+	BOOL Open();
+
+	BOOL IsOpen() {
+		return counters != nullptr;
+	}
+
+	// Unmaps the segment without removing it, in a forked child where the
+	// segment still belongs to the parent.
+	VOID Abandon();
+
+	VOID Update(THREADID tid, AllocationTracker& allocationTracker, ObjectTracker& objectTracker, LanguageTracker& languageTracker, BOOL finished);
+
+	// Unmaps and removes the segment. Readers that still have it mapped keep
+	// the final counters.
+	VOID Close();
+};
+
+#endif // EXPORTER_H
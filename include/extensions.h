@@ -14,8 +14,14 @@ using std::set;
 
 BOOL IMG_IsVdso(IMG img);
 
+// The file names of the images that belong to the C, C++ and Rust runtimes.
+const set<string>& RuntimeImages();
+
 BOOL IMG_IsRuntime(string imgName);
 
+// The names of the routines compilers and linkers add to every program.
+const set<string>& RuntimeRoutines();
+
 BOOL RTN_IsRuntime(RTN rtn);
 
 BOOL RTN_IsPLTStub(RTN rtn);
@@ -28,6 +34,22 @@ BOOL RTN_IsRustLegacy(RTN rtn);
 
 BOOL RTN_IsRust(RTN rtn);
 
+BOOL RTN_IsMemcpy(RTN rtn);
+
+BOOL RTN_IsMemmove(RTN rtn);
+
+BOOL RTN_IsMemset(RTN rtn);
+
+// Whether `rtn` is an IFUNC resolver (e.g. glibc's 'memcpy'), which returns
+// the implementation to call instead of doing the work itself.
+BOOL RTN_IsIFuncResolver(RTN rtn);
+
+string RTN_FindNameByAddress(ADDRINT addr);
+
+// Names `addr` by the file name of its image and its offset in it (e.g.
+// 'libfoo.so+0x1a2b'), which stays the same across runs with ASLR.
+string IMG_FindOffsetByAddress(ADDRINT addr);
+
 template<typename... Args>
 VOID RTN_InstrumentByName(IMG img, const char* name, IPOINT ipoint, AFUNPTR fun, Args... args) {
 	RTN rtn = RTN_FindByName(img, name);
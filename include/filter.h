@@ -0,0 +1,66 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "pin.H"
+
+#include "logger.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+
+// Decides which images and routines get their memory accesses instrumented.
+// Images and routines are matched against comma-separated lists of globs
+// (e.g. "libssl*,libcrypto*"). Image globs match the file name of an image,
+// or its full path if they contain a '/'.
+//
+// Unless an include list says otherwise, the runtime images and routines
+// listed in extensions.cpp are excluded. libc is the exception: Rust and C
+// code both call into it with pointers to their objects (strlen, qsort, ...),
+// so its accesses are part of the picture.
+//
+// Only memory accesses are filtered. Allocator hooks, copy routines and
+// language transitions are instrumented in every image.
+class InstrumentationFilter {
+private:
+	Logger& logger;
+
+	vector<string> includedImages;
+	vector<string> excludedImages;
+	vector<string> includedRoutines;
+	vector<string> excludedRoutines;
+
+	// Whether runtime images and routines are instrumented.
+	BOOL runtime;
+
+	// Decisions are made once per image and routine, while instrumenting
+	// (with Pin's client lock held).
+	map<UINT32, BOOL> images;
+	map<ADDRINT, BOOL> routines;
+
+	// Whether `name` passes `included` and `excluded`, where `isRuntime` says
+	// if it is excluded by default.
+	BOOL Decide(const string& name, const string& path, const vector<string>& included, const vector<string>& excluded, BOOL isRuntime);
+
+public:
+	InstrumentationFilter(Logger& l);
+
+	VOID SetImages(const string& included, const string& excluded);
+
+	VOID SetRoutines(const string& included, const string& excluded);
+
+	VOID SetRuntime(BOOL enabled);
+
+	BOOL Image(IMG img);
+
+	BOOL Routine(RTN rtn);
+
+	// Whether the memory accesses of `ins` are instrumented.
+	BOOL Instruction(INS ins);
+};
+
+#endif // FILTER_H
@@ -0,0 +1,48 @@
+#ifndef HITTERS_H
+#define HITTERS_H
+
+#include "platform.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+// A key tracked by a heavy hitter summary.
+struct Hitter {
+	// The estimated weight of the key, which never underestimates it.
+	UINT64 count;
+
+	// How much `count` may overestimate the real weight.
+	UINT64 error;
+
+	// The number of items folded into this key.
+	UINT64 items;
+
+	// The heaviest item folded into this key, and its weight.
+	string heaviest;
+	UINT64 heaviestWeight;
+};
+
+// Keeps the heaviest keys of a weighted stream in bounded memory, using the
+// Space-Saving algorithm. Once the summary is full, a new key replaces the
+// lightest one and inherits its count as error.
+class HeavyHitters {
+private:
+	USIZE capacity;
+	map<ADDRINT, Hitter> hitters;
+
+public:
+	HeavyHitters(USIZE c);
+
+	VOID Add(ADDRINT key, UINT64 weight, const string& item);
+
+	// The tracked keys, heaviest first.
+	vector<pair<ADDRINT, Hitter>> Top() const;
+};
+
+#endif // HITTERS_H
@@ -1,8 +1,9 @@
 #ifndef LANGUAGE_H
 #define LANGUAGE_H
 
-#include "pin.H"
+#include "platform.h"
 #include "logger.h"
+#include "telemetry.h"
 
 #include <stack>
 #include <string>
@@ -13,29 +14,52 @@ using std::string;
 using std::map;
 using std::endl;
 using std::stack;
+using std::ofstream;
 
 enum class Language {
     RUST,
     C
 };
 
+// The number of languages, for tables indexed by language.
+const UINT32 LANGUAGES = 2;
+
 string LanguageToString(Language lang);
 
 class LanguageTracker {
 private:
 	PIN_LOCK lock;
+	LockStats locks;
 	map<THREADID, Language> language;
 	map<THREADID, stack<Language>> remembered;
 	Logger& logger;
 
+	// The number of times any thread switched from one language to the other,
+	// and how many of those switches went into each language.
+	UINT64 transitions;
+	UINT64 entered[LANGUAGES];
+
 public:
-	LanguageTracker(Logger& l): logger(l) {}
+	LanguageTracker(Logger& l): locks(), logger(l), transitions(0), entered() {}
+
+	// How often the lock was taken (see Telemetry).
+	LockStats& Locks() {
+		return locks;
+	}
+
+	// Resets the tracker in a forked child (see ForkChild in baleen.cpp).
+	VOID AfterFork(THREADID tid);
 
 	Language GetCurrent(THREADID tid);
 
 	VOID Enter(THREADID tid, Language newLang);
 
-	VOID Exit(THREADID tid);
+	// Returns the language of the caller, which is now current again.
+	Language Exit(THREADID tid);
+
+	UINT64 Transitions(THREADID tid);
+
+	VOID Report(ofstream& stream);
 };
 
 #endif // LANGUAGE_H
\ No newline at end of file
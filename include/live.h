@@ -0,0 +1,87 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+// The layout of the shared-memory segment Baleen publishes live counters
+// in. This header is shared with the standalone reader, so it only uses
+// fixed-width types and does not depend on Pin.
+
+#include <stdint.h>
+
+// The segment is named "/baleen-<pid>" (i.e. /dev/shm/baleen-<pid>).
+#define LIVE_SEGMENT_PREFIX "/baleen-"
+
+#define LIVE_MAGIC 0x4E454C41424C4956ULL
+#define LIVE_VERSION 1
+
+// Indices of the per-language counters.
+#define LIVE_RUST 0
+#define LIVE_C 1
+#define LIVE_LANGUAGES 2
+
+#define LIVE_TOP_OBJECTS 16
+#define LIVE_NAME_LENGTH 64
+
+struct LiveObject {
+	char name[LIVE_NAME_LENGTH];
+	uint64_t reads[LIVE_LANGUAGES];
+	uint64_t writes[LIVE_LANGUAGES];
+};
+
+struct LiveCounters {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t pid;
+
+	// Odd while Baleen is updating the counters below. Readers copy the
+	// counters and retry if the sequence was odd or changed meanwhile.
+	uint64_t sequence;
+
+	// Non-zero once the program exited and the counters are final.
+	uint32_t finished;
+	uint32_t objectCount;
+
+	// When the counters were last updated, in nanoseconds since Baleen started.
+	uint64_t updated;
+
+	uint64_t allocated[LIVE_LANGUAGES];
+	uint64_t live[LIVE_LANGUAGES];
+	uint64_t peak[LIVE_LANGUAGES];
+
+	// Accesses to tracked objects, indexed by the language making the access.
+	uint64_t reads[LIVE_LANGUAGES];
+	uint64_t writes[LIVE_LANGUAGES];
+
+	// FFI transitions so far, and per second since the previous update.
+	uint64_t transitions;
+	uint64_t transitionRate;
+
+	// The most accessed objects, hottest first.
+	struct LiveObject objects[LIVE_TOP_OBJECTS];
+};
+
+// Starts an update of `counters` (writer side).
+static inline void LiveBeginWrite(struct LiveCounters* counters) {
+	__atomic_store_n(&counters->sequence, counters->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// Finishes an update of `counters` (writer side).
+static inline void LiveEndWrite(struct LiveCounters* counters) {
+	__atomic_store_n(&counters->sequence, counters->sequence + 1, __ATOMIC_RELEASE);
+}
+
+// Copies a consistent snapshot of `counters` into `snapshot` (reader side).
+static inline void LiveRead(const struct LiveCounters* counters, struct LiveCounters* snapshot) {
+	for (;;) {
+		uint64_t before = __atomic_load_n(&counters->sequence, __ATOMIC_ACQUIRE);
+
+		if (before & 1) continue;
+
+		__builtin_memcpy(snapshot, (const void*)counters, sizeof(*snapshot));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (__atomic_load_n(&counters->sequence, __ATOMIC_RELAXED) == before) return;
+	}
+}
+
+#endif // LIVE_H
@@ -1,19 +1,22 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
-#include "pin.H"
+#include "platform.h"
 #include <fstream>
 #include <map>
+#include <string>
 
 using std::map;
 using std::ofstream;
+using std::string;
 
 enum class LogSubject {
     INSTRUMENTATION,
     EXECUTION,
     MEMORY,
     ACCESS,
-    OBJECTS
+    OBJECTS,
+    TIMELINE
 };
 
 class Logger {
@@ -22,10 +25,23 @@ private:
     
     // Map each subject to its log file
     map<LogSubject, ofstream> streams;
+
+    // The directory that holds the logs and reports of this process
+    string directory;
     
 public:
     Logger();
     ~Logger();
+
+    // Create `dir` and (re)open every log file inside it
+    void Open(const string& dir);
+
+    const string& Directory() {
+        return directory;
+    }
+
+    // Path of `file` inside the output directory
+    string Path(const string& file);
     
     // Stream method that returns the stream for a given subject
     ofstream& Stream(LogSubject subject);
@@ -33,6 +49,12 @@ public:
     // Report stream (separate, for final reports)
     ofstream& GetReportStream();
     
+    // The bytes written to the open logs so far
+    UINT64 Bytes();
+
+    // Write out what every open log has buffered
+    void Flush();
+
     void CloseAll();
 };
 
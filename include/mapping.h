@@ -0,0 +1,122 @@
+#ifndef MAPPING_H
+#define MAPPING_H
+
+#include "pin.H"
+
+#include "language.h"
+#include "logger.h"
+#include "object.h"
+#include "telemetry.h"
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+// A region mapped by mmap, tracked as a single object however big it is.
+struct Mapping {
+	// The name of its object.
+	string name;
+
+	// The file it maps, or empty for anonymous memory.
+	string path;
+
+	USIZE size;
+
+	// The language that mapped it, and the call site.
+	Language lang;
+	ADDRINT site;
+
+	// Every byte it ever had, counting growth through mremap.
+	UINT64 mapped;
+
+	// Its access counts, indexed by the language making the access (only
+	// filled in once it is unmapped).
+	UINT64 reads[LANGUAGES];
+	UINT64 writes[LANGUAGES];
+};
+
+// An mmap or mremap call that has been entered but has not returned yet.
+struct PendingMapping {
+	ADDRINT addr;
+	USIZE oldSize;
+	USIZE size;
+	string path;
+	Language lang;
+	ADDRINT site;
+	BOOL tracked;
+};
+
+// The mmap and mremap calls a thread has entered but that have not returned
+// yet, innermost last (a signal handler can map memory in the middle of
+// another call).
+struct MappingThread {
+	vector<PendingMapping> mmaps;
+	vector<PendingMapping> mremaps;
+};
+
+// Tracks the regions the program maps with mmap, so accesses to big buffers
+// and mapped files are attributed like accesses to heap blocks. Mappings made
+// by the allocators (which serve big blocks with mmap), thread stacks and
+// reservations without access rights are left out.
+class MappingTracker {
+private:
+	PIN_LOCK lock;
+	LockStats locks;
+	Logger& logger;
+
+	// Maps the start of every live mapping to it.
+	map<ADDRINT, Mapping> mappings;
+
+	// Mappings that were unmapped, with their final counts.
+	vector<Mapping> unmapped;
+
+	// The pending calls of every thread, in thread-local storage so entering
+	// a call takes no lock.
+	TLS_KEY key;
+	vector<MappingThread*> threads;
+
+	MappingThread* Thread(THREADID tid);
+
+	// The live mapping that contains `addr`, or the end of `mappings`.
+	map<ADDRINT, Mapping>::iterator Containing(ADDRINT addr);
+
+	// Removes [addr, addr + size) from the tracked mappings, trimming and
+	// splitting the ones it only partly covers.
+	VOID Unmap(THREADID tid, ADDRINT addr, USIZE size, ObjectTracker& objectTracker);
+
+	// Moves the counts of a mapping that is going away into `unmapped`.
+	VOID Close(THREADID tid, Mapping& mapping, ObjectTracker& objectTracker);
+
+public:
+	MappingTracker(Logger& l);
+
+	// Creates the thread-local storage key, after Pin is initialized.
+	VOID Initialize();
+
+	// Resets the tracker in a forked child (see ForkChild in baleen.cpp).
+	VOID AfterFork(THREADID tid);
+
+	// How often the lock was taken (see Telemetry).
+	LockStats& Locks() {
+		return locks;
+	}
+
+	// `inAllocator` tells whether the call comes from inside malloc and co.
+	VOID BeforeMmap(THREADID tid, USIZE size, INT32 prot, INT32 flags, INT32 fd, Language lang, ADDRINT site, BOOL inAllocator);
+	VOID AfterMmap(THREADID tid, ADDRINT returned, ObjectTracker& objectTracker);
+
+	VOID BeforeMunmap(THREADID tid, ADDRINT addr, USIZE size, ObjectTracker& objectTracker);
+
+	VOID BeforeMremap(THREADID tid, ADDRINT oldAddr, USIZE oldSize, USIZE size, Language lang);
+	VOID AfterMremap(THREADID tid, ADDRINT returned, ObjectTracker& objectTracker);
+
+	VOID Report(ofstream& stream, ObjectTracker& objectTracker);
+};
+
+#endif // MAPPING_H
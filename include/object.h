@@ -1,21 +1,170 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
-#include "pin.H"
+#include "platform.h"
 
 #include "registry.h"
 #include "language.h"
 #include "logger.h"
+#ifndef BALEEN_NO_PIN
+#include "extensions.h"
+#endif
+#include "hitters.h"
+#include "utilities.h"
+#include "report.h"
+#include "pattern.h"
+#include "routine.h"
+#include "telemetry.h"
+#include "utilization.h"
+#include "watch.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
 
 using std::hex;
 using std::dec;
 using std::ofstream;
 using std::map;
 using std::endl;
+using std::vector;
+using std::pair;
+using std::array;
+
+// The history of an object that was passed to 'realloc'.
+struct ReallocChain {
+	// The number of times the object was reallocated.
+	UINT64 reallocs;
+
+	// The number of reallocations that increased its size.
+	UINT64 grows;
+
+	// The number of reallocations that moved it to a new address.
+	UINT64 moves;
+
+	// The bytes copied from the old address to the new one by those moves.
+	UINT64 copied;
+
+	// The sum of every size the object had before its last reallocation.
+	UINT64 intermediate;
+
+	// The size after the last reallocation.
+	USIZE final;
+
+	// The number of reallocations made by a language other than the one
+	// that allocated the object.
+	UINT64 crossed;
+};
+
+// The accesses a single routine made to an object.
+struct RoutineCounts {
+	UINT64 reads;
+	UINT64 writes;
+};
+
+// The first access to a page of an object.
+struct PageTouch {
+	// The thread and language that made it.
+	THREADID tid;
+	Language lang;
+
+	// The NUMA node the page was placed on, -1 if it is unknown, or
+	// PAGE_UNPLACED until it is looked up (see ObjectTracker::Place).
+	INT32 node;
+};
+
+// The first access runs before the page is faulted in, so its node is looked
+// up when the object is freed or reported.
+const INT32 PAGE_UNPLACED = -2;
+
+// The allocation site, language and access counts of an object.
+struct ObjectStats {
+	// The call site that allocated the object.
+	ADDRINT site;
+
+	// The language that allocated the object.
+	Language lang;
+
+	// The read and write counts, indexed by the language making the access.
+	UINT64 reads[LANGUAGES];
+	UINT64 writes[LANGUAGES];
+
+	// Maps the ID of every routine that accessed the object to its counts,
+	// indexed by the language making the access.
+	map<UINT32, RoutineCounts> routines[LANGUAGES];
+
+	// Maps the start of every page of the object to its first touch, and
+	// every thread to its accesses indexed by language (only with
+	// SetFirstTouch).
+	map<ADDRINT, PageTouch> pages;
+	map<THREADID, array<UINT64, LANGUAGES>> threads;
+
+	// How every language walks the object, and where every thread last
+	// accessed it in every language (only with SetPatterns).
+	AccessPattern patterns[LANGUAGES];
+	map<THREADID, Walk> walks[LANGUAGES];
+
+	// The bytes that were accessed, and the writes made after the first
+	// read (only with SetUtilization).
+	TouchMap touched;
+	UINT64 lateWrites;
+};
+
+// An object inside another one, registered with the batched markers (see
+// BeforeRegister in baleen.cpp).
+struct NestedObject {
+	ADDRINT addr;
+	USIZE size;
+
+	// The ID of the object's name (see NameObjects), or 0 to number it.
+	UINT64 name;
+};
+
+// Every pointer store is checked against the 1 MiB regions that ever held a
+// registered object, one bit per region, before the stored value is looked up
+// (see IsHeapPointer in baleen.cpp). The brk heap, malloc arenas and mappings
+// are far apart, so only the regions they cover pass. The bitmap covers the
+// 47-bit user address space and is a plain global Pin can inline the check
+// against. Bits are only ever set, with the tracker's lock held, so a racing
+// store sees a region as marked or not yet marked.
+const UINT32 HEAP_REGION_SHIFT = 20;
+const UINT32 HEAP_WORD_SHIFT = HEAP_REGION_SHIFT + 6;
+const USIZE HEAP_REGION_WORDS = (1ULL << 47) >> HEAP_WORD_SHIFT;
+
+struct HeapRegions {
+	UINT64 bits[HEAP_REGION_WORDS];
+};
+
+// The objects Snapshot walks before it lets instrumented threads take the
+// lock again.
+const USIZE SNAPSHOT_CHUNK = 1024;
+
+// A copy of the counts of one of the most accessed objects.
+struct HotObject {
+	string name;
+	UINT64 reads[LANGUAGES];
+	UINT64 writes[LANGUAGES];
+};
+
+// Freed objects of one language and size class, folded together.
+struct FoldedGroup {
+	// The number of objects in this group.
+	UINT64 objects;
+
+	// The read and write counts of those objects.
+	map<Language, UINT64> reads;
+	map<Language, UINT64> writes;
+
+	// The allocation sites whose objects were accessed the most.
+	HeavyHitters sites;
+
+	FoldedGroup(USIZE capacity) : objects(0), sites(capacity) {}
+};
 
 class ObjectTracker {
 private:
 	PIN_LOCK lock;
+	LockStats locks;
 	Logger& logger;
 
 	// Maps every starting address to its object (name and size).
@@ -24,19 +173,287 @@ private:
 	// Maps the name of every object to its starting address.
 	map<string, ADDRINT> starts;
 
-	// Maps the name of every object to its read count.
-	map<string, map<Language, UINT64>> reads;
+	// Maps the name of every object to its allocation site and access counts.
+	map<string, ObjectStats> stats;
 
-	// Maps the name of every object to its write count.
-	map<string, map<Language, UINT64>> writes;
+	// Reads and writes of all objects, including freed ones, indexed by the
+	// language making the access.
+	UINT64 totalReads[LANGUAGES];
+	UINT64 totalWrites[LANGUAGES];
+
+	// Maps the name of every reallocated object to its realloc history.
+	map<string, ReallocChain> chains;
+
+	// Maps every allocation site to the realloc history of its freed objects.
+	map<ADDRINT, pair<UINT64, ReallocChain>> foldedChains;
+
+	// The number of allocation sites kept per group of freed objects, or 0
+	// to keep exact counts for every object.
+	USIZE hitterCapacity;
+
+	// Maps every language and size class to the freed objects in it.
+	map<Language, map<UINT32, FoldedGroup>> folded;
 
 	USIZE objectNumber;
 
+	// Maps the name IDs of nested objects to their names.
+	map<UINT64, string> labels;
+
+	// Whether the first touch of every page is recorded.
+	BOOL firstTouch;
+
+	// Whether accesses are classified as sequential, strided or random.
+	BOOL classify;
+
+	// Whether the bytes every object used are recorded.
+	BOOL utilization;
+
+	// Maps every allocation site and language to the utilization of its
+	// freed objects.
+	map<pair<ADDRINT, Language>, UtilizationGroup> utilized;
+
+	// The objects to watch in watch mode, or nullptr.
+	WatchList* watch;
+
+	// The regions that held a registered object (only with SetRegions).
+	HeapRegions* regions;
+
+	VOID Widen(ADDRINT addr, USIZE size) {
+		if (regions == nullptr || size == 0) return;
+
+		ADDRINT last = (addr + size - 1) >> HEAP_REGION_SHIFT;
+
+		for (ADDRINT region = addr >> HEAP_REGION_SHIFT; region <= last; region++) {
+			regions->bits[(region >> 6) & (HEAP_REGION_WORDS - 1)] |= 1ULL << (region & 63);
+		}
+	}
+
+	VOID Classify(ObjectStats& counts, THREADID tid, ADDRINT addr, Language lang) {
+		UINT32 index = static_cast<UINT32>(lang);
+		counts.patterns[index].Record(counts.walks[index][tid], addr);
+	}
+
+	VOID Use(ObjectStats& counts, Node *object, ADDRINT addr, USIZE size, BOOL write) {
+		counts.touched.Touch(addr - object->start, size);
+
+		if (write) {
+			for (UINT32 index = 0; index < LANGUAGES; index++) {
+				if (counts.reads[index] > 0) {
+					counts.lateWrites++;
+					break;
+				}
+			}
+		}
+	}
+
+	VOID Touch(ObjectStats& counts, THREADID tid, ADDRINT addr, Language lang) {
+		ADDRINT page = addr & ~(PAGE_BYTES - 1);
+
+		if (counts.pages.find(page) == counts.pages.end()) {
+			counts.pages[page] = { tid, lang, PAGE_UNPLACED };
+		}
+
+		counts.threads[tid][static_cast<UINT32>(lang)]++;
+	}
+
+	// Looks up the nodes of the pages of an object that were not placed yet.
+	VOID Place(ObjectStats& counts) {
+		vector<ADDRINT> pages;
+		vector<INT32> nodes;
+
+		for (const auto& page : counts.pages) {
+			if (page.second.node == PAGE_UNPLACED) {
+				pages.push_back(page.first);
+			}
+		}
+
+		if (pages.empty()) return;
+
+		PageNodes(pages, nodes);
+
+		for (size_t i = 0; i < pages.size(); i++) {
+			counts.pages[pages[i]].node = nodes[i];
+		}
+	}
+
+	VOID FoldChain(const string& name) {
+		auto it = chains.find(name);
+
+		if (it == chains.end()) return;
+
+		const ReallocChain& chain = it->second;
+		auto& entry = foldedChains[stats[name].site];
+
+		entry.first += 1;
+		entry.second.reallocs += chain.reallocs;
+		entry.second.grows += chain.grows;
+		entry.second.moves += chain.moves;
+		entry.second.copied += chain.copied;
+		entry.second.intermediate += chain.intermediate;
+		entry.second.final += chain.final;
+		entry.second.crossed += chain.crossed;
+
+		chains.erase(it);
+	}
+
+	// Folds a freed object into the summary of its language and size class,
+	// and forgets its exact counts.
+	VOID Fold(Node *object) {
+		const string& name = object->name;
+
+		auto it = folded[object->lang].try_emplace(SizeClass(object->size), hitterCapacity).first;
+		FoldedGroup& group = it->second;
+
+		const ObjectStats& counts = stats[name];
+		UINT64 accesses = 0;
+
+		for (Language lang : { Language::RUST, Language::C }) {
+			UINT32 index = static_cast<UINT32>(lang);
+
+			group.reads[lang] += counts.reads[index];
+			group.writes[lang] += counts.writes[index];
+
+			accesses += counts.reads[index] + counts.writes[index];
+		}
+
+		group.objects += 1;
+		group.sites.Add(counts.site, accesses, name);
+
+		FoldChain(name);
+
+		starts.erase(name);
+		stats.erase(name);
+	}
+
+	// Forgets a removed object and every object nested in it.
+	VOID Release(Node *object) {
+		ReleaseTree(object->inner);
+
+		if (watch) {
+			watch->Remove(object->name);
+		}
+
+		logger.Stream(LogSubject::OBJECTS) << "[REMOVE OBJECT] Object '" << object->name
+			<< "' is no longer mapped to range [0x" << hex << object->start
+			<< ", 0x" << object->start + object->size
+			<< ")" << dec << endl;
+
+		if (firstTouch) {
+			Place(stats[object->name]);
+		}
+
+		if (utilization) {
+			ObjectStats& counts = stats[object->name];
+
+			utilized[{ counts.site, counts.lang }].Add(counts.lang, counts.touched, counts.reads, counts.writes, counts.lateWrites);
+			counts.touched.Clear();
+		}
+
+		if (hitterCapacity > 0) {
+			Fold(object);
+		} else {
+			// TODO: Is this a good way to handle the start address mapping?
+			starts[object->name] = 0;
+		}
+
+		delete object;
+	}
+
+	// Forgets the objects nested in `object` that are no longer inside it,
+	// e.g. after it shrank.
+	VOID ClipNested(Node *object) {
+		vector<Node*> outside;
+		Registry::clip(object->inner, object->start, object->start + object->size, outside);
+
+		for (Node *nested : outside) {
+			Release(nested);
+		}
+	}
+
+	// Moves the first touches of an object by `delta` bytes, and forgets the
+	// pages it no longer covers at [start, start + size). Pages that moved
+	// are different pages, so their nodes are looked up again.
+	VOID MovePages(ObjectStats& counts, ADDRINT delta, ADDRINT start, USIZE size) {
+		if (counts.pages.empty()) return;
+
+		map<ADDRINT, PageTouch> pages;
+
+		for (const auto& entry : counts.pages) {
+			ADDRINT page = (entry.first + delta) & ~(PAGE_BYTES - 1);
+
+			if (page >= start + size || page + PAGE_BYTES <= start) continue;
+
+			PageTouch touch = entry.second;
+
+			if (delta != 0) {
+				touch.node = PAGE_UNPLACED;
+			}
+
+			pages.emplace(page, touch);
+		}
+
+		counts.pages.swap(pages);
+	}
+
+	// Starts the counts of a new object from zero.
+	VOID Count(const string& name, USIZE size, Language lang, ADDRINT site) {
+		ObjectStats& counts = stats[name];
+
+		counts = ObjectStats();
+		counts.site = site;
+		counts.lang = lang;
+		counts.touched.Resize(size, 0);
+	}
+
+	VOID ReleaseTree(Node *tree) {
+		if (tree == nullptr) return;
+
+		ReleaseTree(tree->left);
+		ReleaseTree(tree->right);
+		Release(tree);
+	}
+
 public:
 	ObjectTracker(Logger& l);
 
-	VOID RegisterObject(THREADID tid, ADDRINT addr, ADDRINT size, Language lang, ADDRINT name) {
-		PIN_GetLock(&lock, tid + 1);
+	// Resets the tracker in a forked child (see ForkChild in baleen.cpp).
+	VOID AfterFork(THREADID tid);
+
+	VOID SetHeavyHitters(USIZE capacity) {
+		hitterCapacity = capacity;
+	}
+
+	VOID SetFirstTouch(BOOL enabled) {
+		firstTouch = enabled;
+	}
+
+	VOID SetPatterns(BOOL enabled) {
+		classify = enabled;
+	}
+
+	VOID SetUtilization(BOOL enabled) {
+		utilization = enabled;
+	}
+
+	VOID SetWatch(WatchList* list) {
+		watch = list;
+	}
+
+	VOID SetRegions(HeapRegions* heap) {
+		regions = heap;
+	}
+
+	// How often the lock was taken (see Telemetry).
+	LockStats& Locks() {
+		return locks;
+	}
+
+	const RegistryStats& Lookups() {
+		return objects.lookups();
+	}
+
+	VOID RegisterObject(THREADID tid, ADDRINT addr, ADDRINT size, Language lang, ADDRINT name, ADDRINT site) {
+		AcquireLock(&lock, tid, locks);
 
 		// Read object name
 		string objectName = std::to_string(objectNumber);
@@ -49,19 +466,24 @@ public:
 			objectName = buffer;
 		}
 
-		// Map the address range to the object name
-		objects.insert(addr, size, objectName, lang);
-		starts[objectName] = addr;
+		// Map the address range to the object name, forgetting an object
+		// whose free was missed
+		Node *replaced;
+		objects.insert(addr, size, objectName, lang, &replaced);
 
-		// Initialize counts
-		reads[objectName] = {};
-        writes[objectName] = {};
+		if (replaced) {
+			Release(replaced);
+		}
 
-        reads[objectName][Language::C] = 0;
-        reads[objectName][Language::RUST] = 0;
+		starts[objectName] = addr;
+		Widen(addr, size);
 
-        writes[objectName][Language::C] = 0;
-        writes[objectName][Language::RUST] = 0;
+		if (watch) {
+			watch->Add(objectName, addr, size);
+		}
+
+		// Initialize counts
+		Count(objectName, size, lang, site);
 
 		logger.Stream(LogSubject::OBJECTS) << "[REGISTER OBJECT] Object '" << objectName
 			<< "' occupies " << size
@@ -72,46 +494,284 @@ public:
 		PIN_ReleaseLock(&lock);
 	}
 
-	VOID MoveObject(THREADID tid, ADDRINT oldAddr, ADDRINT newAddr, USIZE size) {
-		if (oldAddr == newAddr) return;
+	// Returns whether the object at `oldAddr` was tracked.
+	BOOL MoveObject(THREADID tid, ADDRINT oldAddr, ADDRINT newAddr, USIZE size, Language lang) {
+		AcquireLock(&lock, tid, locks);
 
 		Node *node = objects.remove(oldAddr);
+		BOOL tracked = node != nullptr;
 
-		if (node) {
-			logger.Stream(LogSubject::OBJECTS) << "[MOVE OBJECT] Object '" << node->name
-				<< "' was moved!" << endl;
-			
-			logger.Stream(LogSubject::OBJECTS) << "[MOVE OBJECT] - [0x" << hex << node->start
-				<< ", 0x" << node->start + node->size
-				<< ") → [0x" << newAddr
-				<< ", 0x" << newAddr + size
-				<< ")" << dec << endl;
+		if (tracked) {
+			ReallocChain& chain = chains[node->name];
+			chain.reallocs += 1;
+			chain.intermediate += node->size;
+			chain.final = size;
+
+			if (size > node->size) {
+				chain.grows += 1;
+			}
+
+			if (lang != node->lang) {
+				chain.crossed += 1;
+			}
+
+			if (oldAddr != newAddr) {
+				chain.moves += 1;
+				chain.copied += std::min(node->size, size);
+
+				logger.Stream(LogSubject::OBJECTS) << "[MOVE OBJECT] Object '" << node->name
+					<< "' was moved!" << endl;
+				
+				logger.Stream(LogSubject::OBJECTS) << "[MOVE OBJECT] - [0x" << hex << node->start
+					<< ", 0x" << node->start + node->size
+					<< ") → [0x" << newAddr
+					<< ", 0x" << newAddr + size
+					<< ")" << dec << endl;
+			}
 			
 			logger.Stream(LogSubject::OBJECTS) << "[MOVE OBJECT] - " << node->size
 				<< " → " << size
 				<< " bytes" << endl;
 			
-			objects.insert(newAddr, size, node->name, node->lang);
+			// Nested objects move along with the block
+			Node *replaced;
+			Node *moved = objects.insert(newAddr, size, node->name, node->lang, &replaced);
+
+			if (replaced) {
+				Release(replaced);
+			}
+
+			moved->inner = node->inner;
+			Registry::shift(moved->inner, newAddr - oldAddr);
+			ClipNested(moved);
+			Widen(newAddr, size);
+
+			if (watch) {
+				watch->Move(node->name, newAddr, size);
+			}
+
+			// The bytes realloc copied keep their offsets
+			ObjectStats& counts = stats[node->name];
 			starts[node->name] = newAddr;
+			counts.touched.Resize(size, 0);
+			MovePages(counts, newAddr - oldAddr, newAddr, size);
+
+			delete node;
 		}
+
+		PIN_ReleaseLock(&lock);
+
+		return tracked;
 	}
 
 	VOID RemoveObject(THREADID tid, ADDRINT addr) {
+		AcquireLock(&lock, tid, locks);
+
 		Node *object = objects.remove(addr);
 
 		if (object) {
-			logger.Stream(LogSubject::OBJECTS) << "[REMOVE OBJECT] Object '" << object->name
-				<< "' is no longer mapped to range [0x" << hex << object->start
-				<< ", 0x" << object->start + object->size
+			Release(object);
+		}
+
+		PIN_ReleaseLock(&lock);
+	}
+
+	// Registers a region the program did not get from the allocators (e.g. a
+	// mapping), named after `label` and numbered. Returns its name.
+	string RegisterRegion(THREADID tid, ADDRINT addr, USIZE size, Language lang, const string& label, ADDRINT site) {
+		AcquireLock(&lock, tid, locks);
+
+		string objectName = label + "#" + std::to_string(objectNumber);
+		objectNumber += 1;
+
+		Node *replaced;
+		objects.insert(addr, size, objectName, lang, &replaced);
+
+		if (replaced) {
+			Release(replaced);
+		}
+
+		starts[objectName] = addr;
+		Count(objectName, size, lang, site);
+		Widen(addr, size);
+
+		if (watch) {
+			watch->Add(objectName, addr, size);
+		}
+
+		logger.Stream(LogSubject::OBJECTS) << "[REGISTER REGION] Object '" << objectName
+			<< "' occupies " << size
+			<< " bytes in range [0x" << hex << addr
+			<< ", 0x" << addr + size
+			<< ")" << dec << endl;
+
+		PIN_ReleaseLock(&lock);
+
+		return objectName;
+	}
+
+	// Moves or trims the object at `oldAddr` without counting a realloc (e.g.
+	// when part of a mapping is unmapped).
+	VOID ReshapeObject(THREADID tid, ADDRINT oldAddr, ADDRINT newAddr, USIZE size) {
+		AcquireLock(&lock, tid, locks);
+
+		Node *node = objects.remove(oldAddr);
+
+		if (node) {
+			Node *replaced;
+			Node *reshaped = objects.insert(newAddr, size, node->name, node->lang, &replaced);
+
+			if (replaced) {
+				Release(replaced);
+			}
+
+			reshaped->inner = node->inner;
+			ClipNested(reshaped);
+
+			// The bytes that are left keep their addresses
+			ObjectStats& counts = stats[node->name];
+			starts[node->name] = newAddr;
+			counts.touched.Resize(size, newAddr - oldAddr);
+			MovePages(counts, 0, newAddr, size);
+			Widen(newAddr, size);
+
+			if (watch) {
+				watch->Move(node->name, newAddr, size);
+			}
+
+			delete node;
+		}
+
+		PIN_ReleaseLock(&lock);
+	}
+
+	// Copies the access counts of the object called `name`.
+	BOOL Counts(THREADID tid, const string& name, UINT64 reads[], UINT64 writes[]) {
+		AcquireLock(&lock, tid, locks);
+
+		auto it = stats.find(name);
+		BOOL found = it != stats.end();
+
+		if (found) {
+			for (UINT32 index = 0; index < LANGUAGES; index++) {
+				reads[index] = it->second.reads[index];
+				writes[index] = it->second.writes[index];
+			}
+		}
+
+		PIN_ReleaseLock(&lock);
+
+		return found;
+	}
+
+	VOID NameObjects(THREADID tid, UINT64 id, const string& name) {
+		AcquireLock(&lock, tid, locks);
+		labels[id] = name;
+		PIN_ReleaseLock(&lock);
+	}
+
+	// Registers a batch of objects inside registered objects (e.g. the
+	// allocations of an arena or the slots of a slab), under one lock.
+	// Objects outside of every registered object are ignored.
+	VOID RegisterNested(THREADID tid, const NestedObject* nested, USIZE count, Language lang, ADDRINT site) {
+		AcquireLock(&lock, tid, locks);
+
+		for (USIZE i = 0; i < count; i++) {
+			if (nested[i].size == 0) continue;
+
+			string objectName = std::to_string(objectNumber);
+			objectNumber += 1;
+
+			auto label = labels.find(nested[i].name);
+
+			if (label != labels.end()) {
+				objectName = label->second + "#" + objectName;
+			}
+
+			// A slot registered again at the same range was reused without
+			// being unregistered, so the object in it is forgotten first
+			Node *replaced;
+
+			if (!objects.insertNested(nested[i].addr, nested[i].size, objectName, lang, &replaced)) {
+				logger.Stream(LogSubject::OBJECTS) << "[REGISTER NESTED] Range [0x" << hex << nested[i].addr
+					<< ", 0x" << nested[i].addr + nested[i].size
+					<< ") is not inside a registered object" << dec << endl;
+				continue;
+			}
+
+			if (replaced) {
+				Release(replaced);
+			}
+
+			starts[objectName] = nested[i].addr;
+			Count(objectName, nested[i].size, lang, site);
+
+			if (watch) {
+				watch->Add(objectName, nested[i].addr, nested[i].size);
+			}
+
+			logger.Stream(LogSubject::OBJECTS) << "[REGISTER NESTED] Object '" << objectName
+				<< "' occupies " << nested[i].size
+				<< " bytes in range [0x" << hex << nested[i].addr
+				<< ", 0x" << nested[i].addr + nested[i].size
 				<< ")" << dec << endl;
-		
-			// TODO: Is this a good way to handle the start address mapping?
-			starts[object->name] = 0;
 		}
+
+		PIN_ReleaseLock(&lock);
+	}
+
+	VOID UnregisterNested(THREADID tid, const ADDRINT* addrs, USIZE count) {
+		AcquireLock(&lock, tid, locks);
+
+		for (USIZE i = 0; i < count; i++) {
+			Node *object = objects.removeNested(addrs[i]);
+
+			if (object) {
+				Release(object);
+			}
+		}
+
+		PIN_ReleaseLock(&lock);
+	}
+
+	// Finds the object containing `addr` along with the language that created it.
+	BOOL Resolve(THREADID tid, ADDRINT addr, string& name, Language& lang) {
+		AcquireLock(&lock, tid, locks);
+
+		auto object = objects.find(addr);
+
+		if (object) {
+			name = object->name;
+			lang = object->lang;
+		}
+
+		PIN_ReleaseLock(&lock);
+
+		return object != nullptr;
+	}
+
+	// Finds the objects containing `addr` and `value`, under one lock.
+	BOOL ResolvePointer(THREADID tid, ADDRINT addr, ADDRINT value, string& holder, Language& holderLang, string& pointee, Language& pointeeLang) {
+		AcquireLock(&lock, tid, locks);
+
+		auto target = objects.find(value);
+		auto object = target ? objects.find(addr) : nullptr;
+
+		if (object) {
+			holder = object->name;
+			holderLang = object->lang;
+			pointee = target->name;
+			pointeeLang = target->lang;
+		}
+
+		PIN_ReleaseLock(&lock);
+
+		return object != nullptr;
 	}
 
-	VOID RecordWrite(THREADID tid, ADDRINT addr, Language lang) {
-		PIN_GetLock(&lock, tid + 1);
+	// Returns whether `addr` belongs to a tracked object.
+	BOOL RecordWrite(THREADID tid, ADDRINT addr, USIZE size, Language lang, UINT32 routine) {
+		AcquireLock(&lock, tid, locks);
 
 		auto object = objects.find(addr);
 
@@ -121,14 +781,32 @@ public:
 				<< "')" << dec
 				<< endl;
 
-			writes[object->name][lang]++;
+			ObjectStats& counts = stats[object->name];
+			counts.writes[static_cast<UINT32>(lang)]++;
+			totalWrites[static_cast<UINT32>(lang)]++;
+			counts.routines[static_cast<UINT32>(lang)][routine].writes++;
+
+			if (firstTouch) {
+				Touch(counts, tid, addr, lang);
+			}
+
+			if (classify) {
+				Classify(counts, tid, addr, lang);
+			}
+
+			if (utilization) {
+				Use(counts, object, addr, size, true);
+			}
 		}
 
 		PIN_ReleaseLock(&lock);
+
+		return object != nullptr;
 	}
 
-	VOID RecordRead(THREADID tid, ADDRINT addr, Language lang) {
-		PIN_GetLock(&lock, tid + 1);
+	// Returns whether `addr` belongs to a tracked object.
+	BOOL RecordRead(THREADID tid, ADDRINT addr, USIZE size, Language lang, UINT32 routine) {
+		AcquireLock(&lock, tid, locks);
 
 		auto object = objects.find(addr);
 
@@ -137,29 +815,261 @@ public:
 			    << " ('" << object->name
 				<< "')" << dec << endl;
 
-			reads[object->name][lang]++;
+			ObjectStats& counts = stats[object->name];
+			counts.reads[static_cast<UINT32>(lang)]++;
+			totalReads[static_cast<UINT32>(lang)]++;
+			counts.routines[static_cast<UINT32>(lang)][routine].reads++;
+
+			if (firstTouch) {
+				Touch(counts, tid, addr, lang);
+			}
+
+			if (classify) {
+				Classify(counts, tid, addr, lang);
+			}
+
+			if (utilization) {
+				Use(counts, object, addr, size, false);
+			}
 		}
 
 		PIN_ReleaseLock(&lock);
+
+		return object != nullptr;
+	}
+
+	// Copies the access totals and the `count` most accessed live objects.
+	VOID Snapshot(THREADID tid, USIZE count, UINT64 reads[], UINT64 writes[], vector<HotObject>& hottest) {
+		typedef pair<UINT64, HotObject> Candidate;
+
+		// A min-heap of the hottest objects seen so far
+		vector<Candidate> heap;
+		auto hotter = [](const Candidate& a, const Candidate& b) { return a.first > b.first; };
+
+		AcquireLock(&lock, tid, locks);
+
+		for (UINT32 index = 0; index < LANGUAGES; index++) {
+			reads[index] = totalReads[index];
+			writes[index] = totalWrites[index];
+		}
+
+		// The objects are walked a chunk at a time, and the lock is released
+		// in between so instrumented threads never wait for the whole walk.
+		// Objects are copied, since they may be freed between chunks.
+		auto it = stats.begin();
+
+		while (it != stats.end()) {
+			for (USIZE walked = 0; it != stats.end() && walked < SNAPSHOT_CHUNK; ++it, ++walked) {
+				UINT64 total = 0;
+
+				for (UINT32 index = 0; index < LANGUAGES; index++) {
+					total += it->second.reads[index] + it->second.writes[index];
+				}
+
+				if (count == 0 || (heap.size() == count && total <= heap.front().first)) continue;
+
+				// Freed objects keep their counts unless they are folded
+				auto start = starts.find(it->first);
+
+				if (start == starts.end() || start->second == 0) continue;
+
+				HotObject object;
+				object.name = it->first;
+
+				for (UINT32 index = 0; index < LANGUAGES; index++) {
+					object.reads[index] = it->second.reads[index];
+					object.writes[index] = it->second.writes[index];
+				}
+
+				if (heap.size() == count) {
+					std::pop_heap(heap.begin(), heap.end(), hotter);
+					heap.pop_back();
+				}
+
+				heap.emplace_back(total, object);
+				std::push_heap(heap.begin(), heap.end(), hotter);
+			}
+
+			if (it == stats.end()) break;
+
+			string next = it->first;
+
+			PIN_ReleaseLock(&lock);
+			AcquireLock(&lock, tid, locks);
+
+			it = stats.lower_bound(next);
+		}
+
+		PIN_ReleaseLock(&lock);
+
+		std::sort_heap(heap.begin(), heap.end(), hotter);
+
+		hottest.clear();
+
+		for (const Candidate& candidate : heap) {
+			hottest.push_back(candidate.second);
+		}
+	}
+
+	VOID Report(ofstream& stream, ReportFormat format, USIZE top) {
+		// Totals include freed and folded objects, and objects beyond `top`
+		stream << "--- Access Report ---" << endl;
+		stream << "Reads (Rust):   " << totalReads[static_cast<UINT32>(Language::RUST)] << endl;
+		stream << "Reads (C):      " << totalReads[static_cast<UINT32>(Language::C)] << endl;
+		stream << "Writes (Rust):  " << totalWrites[static_cast<UINT32>(Language::RUST)] << endl;
+		stream << "Writes (C):     " << totalWrites[static_cast<UINT32>(Language::C)] << endl;
+		stream << endl;
+
+		vector<ObjectRow> rows;
+		rows.reserve(stats.size());
+
+		for (const auto& pair : stats) {
+			const ObjectStats& counts = pair.second;
+			UINT64 total = 0;
+
+			for (UINT32 index = 0; index < LANGUAGES; index++) {
+				total += counts.reads[index] + counts.writes[index];
+			}
+
+			rows.push_back({ &pair.first, counts.site, counts.lang, counts.reads, counts.writes, total, classify ? counts.patterns : nullptr });
+		}
+
+		WriteObjects(stream, format, logger.Directory(), rows, top);
 	}
 
-	VOID Report(ofstream& stream) {
-		stream << "Name | Reads (Rust) | Reads (C) | Writes (Rust) | Writes (C)" << endl;
+	VOID ReportRoutines(ofstream& stream, RoutineTable& routines, USIZE top) {
+		// A routine, the object it accessed, and its counts
+		typedef std::tuple<UINT32, const string*, RoutineCounts> Pair;
 
-		for (const auto& pair : reads) {
-			const string& objName = pair.first;
+		stream << "--- Routine Report ---" << endl;
+		stream << "Language, Routine, Object, Reads, Writes" << endl;
+
+		for (Language lang : { Language::RUST, Language::C }) {
+			UINT32 index = static_cast<UINT32>(lang);
+			vector<Pair> pairs;
+
+			for (const auto& object : stats) {
+				for (const auto& routine : object.second.routines[index]) {
+					pairs.emplace_back(routine.first, &object.first, routine.second);
+				}
+			}
+
+			USIZE count = std::min(top, pairs.size());
+
+			std::partial_sort(pairs.begin(), pairs.begin() + count, pairs.end(), [](const Pair& a, const Pair& b) {
+				const RoutineCounts& x = std::get<2>(a);
+				const RoutineCounts& y = std::get<2>(b);
+				return x.reads + x.writes > y.reads + y.writes;
+			});
+
+			for (USIZE i = 0; i < count; i++) {
+				const RoutineCounts& counts = std::get<2>(pairs[i]);
+
+				stream << LanguageToString(lang) << ", "
+					<< routines.Name(std::get<0>(pairs[i])) << ", "
+					<< *std::get<1>(pairs[i]) << ", "
+					<< counts.reads << ", "
+					<< counts.writes << endl;
+			}
+		}
+
+		stream << endl;
+	}
+
+	VOID ReportHeavyHitters(ofstream& stream) {
+		if (hitterCapacity == 0) return;
+
+		stream << "--- Heavy Hitters Report ---" << endl;
+		stream << "Language, Size Class, Freed Objects, Reads (Rust), Reads (C), Writes (Rust), Writes (C)" << endl;
+
+		for (auto& byLang : folded) {
+			for (auto& bySize : byLang.second) {
+				FoldedGroup& group = bySize.second;
+
+				stream << LanguageToString(byLang.first) << ", "
+					<< SizeClassToString(bySize.first) << ", "
+					<< group.objects << ", "
+					<< group.reads[Language::RUST] << ", "
+					<< group.reads[Language::C] << ", "
+					<< group.writes[Language::RUST] << ", "
+					<< group.writes[Language::C] << endl;
+			}
+		}
+
+		stream << endl;
+
+		stream << "Language, Size Class, Site, Objects, Accesses, Error, Hottest Object, Hottest Accesses" << endl;
+
+		for (const auto& byLang : folded) {
+			for (const auto& bySize : byLang.second) {
+				for (const auto& entry : bySize.second.sites.Top()) {
+					const Hitter& hitter = entry.second;
+
+					stream << LanguageToString(byLang.first) << ", "
+						<< SizeClassToString(bySize.first) << ", "
+						<< "0x" << hex << entry.first << dec
+						<< " (" << RTN_FindNameByAddress(entry.first) << "), "
+						<< hitter.items << ", "
+						<< hitter.count << ", "
+						<< hitter.error << ", "
+						<< hitter.heaviest << ", "
+						<< hitter.heaviestWeight << endl;
+				}
+			}
+		}
+
+		stream << endl;
+	}
+
+	// Lists the objects mostly accessed by a thread other than the one that
+	// first touched (and so placed) most of their pages.
+	VOID ReportFirstTouch(ofstream& stream);
+
+	// Lists the bytes every allocation site never used, and its objects that
+	// were only written, or only read once they were first read.
+	VOID ReportUtilization(ofstream& stream);
+
+	VOID ReportReallocs(ofstream& stream) {
+		// Fold the chain of every object into the call site that allocated it
+		map<ADDRINT, pair<UINT64, ReallocChain>> bySite = foldedChains;
+
+		for (const auto& pair : chains) {
+			const ReallocChain& chain = pair.second;
+			auto& entry = bySite[stats[pair.first].site];
+
+			entry.first += 1;
+			entry.second.reallocs += chain.reallocs;
+			entry.second.grows += chain.grows;
+			entry.second.moves += chain.moves;
+			entry.second.copied += chain.copied;
+			entry.second.intermediate += chain.intermediate;
+			entry.second.final += chain.final;
+			entry.second.crossed += chain.crossed;
+		}
 
-			stream << objName << ", ";
+		vector<pair<ADDRINT, pair<UINT64, ReallocChain>>> sorted(bySite.begin(), bySite.end());
 
-			int rustReads = reads[objName][Language::RUST];
-			int cReads = reads[objName][Language::C];
+		// Show the sites that copy the most bytes first
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+			return a.second.second.copied > b.second.second.copied;
+		});
 
-			stream << rustReads << ", " << cReads << ", ";
+		stream << "--- Realloc Report ---" << endl;
+		stream << "Site, Objects, Reallocs, Grows, Moves, Bytes Copied, Final Bytes, Intermediate Bytes, Cross-Language Reallocs" << endl;
 
-			int rustWrites = writes[objName][Language::RUST];
-			int cWrites = writes[objName][Language::C];
+		for (const auto& entry : sorted) {
+			const ReallocChain& chain = entry.second.second;
 
-			stream << rustWrites << ", " << cWrites << endl;
+			stream << "0x" << hex << entry.first << dec
+				<< " (" << RTN_FindNameByAddress(entry.first) << "), "
+				<< entry.second.first << ", "
+				<< chain.reallocs << ", "
+				<< chain.grows << ", "
+				<< chain.moves << ", "
+				<< chain.copied << ", "
+				<< chain.final << ", "
+				<< chain.intermediate << ", "
+				<< chain.crossed << endl;
 		}
 
 		stream << endl;
@@ -0,0 +1,54 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include "platform.h"
+
+#include <map>
+#include <string>
+
+using std::map;
+using std::string;
+
+enum class Pattern {
+	SEQUENTIAL,
+	STRIDED,
+	RANDOM
+};
+
+const UINT32 PATTERNS = 3;
+
+string PatternToString(Pattern pattern);
+
+// Accesses at most this many bytes away from the previous one are sequential.
+const INT64 SEQUENTIAL_BYTES = 16;
+
+// Where a thread last accessed an object in one language, and the distance
+// from the access before that.
+struct Walk {
+	ADDRINT last;
+	INT64 stride;
+	BOOL started;
+};
+
+// How one language walks an object, over all threads.
+struct AccessPattern {
+	// The accesses of every pattern.
+	UINT64 counts[PATTERNS];
+
+	// Maps the distance between consecutive sequential or strided accesses
+	// to how often it occurred.
+	map<INT64, UINT64> strides;
+
+	// Classifies an access to `addr` that continues `walk`.
+	VOID Record(Walk& walk, ADDRINT addr);
+
+	BOOL Empty() const;
+
+	// The pattern of most accesses.
+	Pattern Dominant() const;
+
+	// The most common distance between accesses that were not random, or 0.
+	INT64 Stride() const;
+};
+
+#endif // PATTERN_H
@@ -0,0 +1,112 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// The core of Baleen (the registry, the trackers and the report writers) only
+// needs Pin for a few types, its locks, thread-local storage and safe memory
+// reads. This header is the thin layer between the two: inside the Pin tool
+// it is pin.H, and when built with BALEEN_NO_PIN it is a small standard
+// implementation, so the core can be built into a static library and
+// benchmarked outside of Pin (see benchmarks/microbench.cpp). Instrumentation
+// code includes pin.H directly.
+
+#ifdef BALEEN_NO_PIN
+
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef void VOID;
+typedef bool BOOL;
+typedef int32_t INT32;
+typedef uint8_t UINT8;
+typedef uint32_t UINT32;
+typedef int64_t INT64;
+typedef uint64_t UINT64;
+typedef uintptr_t ADDRINT;
+typedef size_t USIZE;
+typedef uint32_t THREADID;
+typedef int32_t TLS_KEY;
+
+struct PIN_LOCK {
+	std::mutex mutex;
+};
+
+// Locks are only re-initialized in forked children, which the standard
+// implementation never is.
+inline VOID PIN_InitLock(PIN_LOCK*) {
+}
+
+inline VOID PIN_GetLock(PIN_LOCK* lock, INT32) {
+	lock->mutex.lock();
+}
+
+inline VOID PIN_ReleaseLock(PIN_LOCK* lock) {
+	lock->mutex.unlock();
+}
+
+// Numbers threads from 0 in the order they first ask, like Pin does.
+inline THREADID PIN_ThreadId() {
+	static std::atomic<THREADID> next(0);
+	thread_local THREADID id = next++;
+
+	return id;
+}
+
+inline TLS_KEY PIN_CreateThreadDataKey(VOID (*)(VOID*)) {
+	static std::atomic<TLS_KEY> next(0);
+	return next++;
+}
+
+// Only the calling thread's data can be reached, which is all the trackers
+// ever ask for.
+inline std::vector<VOID*>& ThreadDataSlots() {
+	thread_local std::vector<VOID*> slots;
+	return slots;
+}
+
+inline VOID* PIN_GetThreadData(TLS_KEY key, THREADID) {
+	std::vector<VOID*>& slots = ThreadDataSlots();
+	return static_cast<size_t>(key) < slots.size() ? slots[key] : nullptr;
+}
+
+inline BOOL PIN_SetThreadData(TLS_KEY key, const VOID* data, THREADID) {
+	std::vector<VOID*>& slots = ThreadDataSlots();
+
+	if (static_cast<size_t>(key) >= slots.size()) {
+		slots.resize(key + 1, nullptr);
+	}
+
+	slots[key] = const_cast<VOID*>(data);
+	return true;
+}
+
+// Outside of Pin there is no fault handling, so callers must pass memory that
+// can be read.
+inline USIZE PIN_SafeCopy(VOID* dst, const VOID* src, USIZE size) {
+	memcpy(dst, src, size);
+	return size;
+}
+
+// There are no symbols to look addresses up in.
+inline std::string RTN_FindNameByAddress(ADDRINT) {
+	return "?";
+}
+
+// Nor images, so addresses stay absolute.
+inline std::string IMG_FindOffsetByAddress(ADDRINT addr) {
+	char location[32];
+	snprintf(location, sizeof(location), "0x%llx", static_cast<unsigned long long>(addr));
+	return location;
+}
+
+#else
+
+#include "pin.H"
+
+#endif // BALEEN_NO_PIN
+
+#endif // PLATFORM_H
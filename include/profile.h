@@ -0,0 +1,87 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "pin.H"
+
+#include "language.h"
+
+#include <fstream>
+#include <vector>
+
+using std::ofstream;
+using std::vector;
+
+// Execution counts of a single thread, split by the current language and by
+// whether the code belongs to a runtime image (libc, libstdc++, ld.so, ...).
+struct ThreadProfile {
+	THREADID tid;
+
+	// The index of the language this thread is currently running.
+	UINT32 lang;
+
+	// When this thread last switched languages, in nanoseconds.
+	UINT64 since;
+
+	// Whether this thread has exited.
+	BOOL finished;
+
+	// The basic blocks this thread executed.
+	UINT64 blocks;
+
+	UINT64 instructions[LANGUAGES][2];
+	UINT64 memoryOps[LANGUAGES][2];
+
+	// Wall time spent in each language, in nanoseconds.
+	UINT64 time[LANGUAGES];
+};
+
+class ExecutionProfiler {
+private:
+	PIN_LOCK lock;
+	TLS_KEY key;
+
+	// Whether profiling was enabled with -profile.
+	BOOL enabled;
+
+	// The profile of every thread that ever started.
+	vector<ThreadProfile*> threads;
+
+	VOID Flush(ThreadProfile* profile, UINT64 now);
+
+public:
+	ExecutionProfiler();
+
+	// Enables profiling and creates the thread-local storage key, after Pin
+	// is initialized.
+	VOID Initialize();
+
+	// Keeps only the profile of the thread that called fork, emptied, in the
+	// forked child.
+	VOID AfterFork(THREADID tid);
+
+	// Returns the profile of the new thread, which the instrumentation keeps
+	// in a tool register so counting a block needs no lookup.
+	ThreadProfile* ThreadStart(THREADID tid);
+	VOID ThreadFini(THREADID tid);
+
+	VOID Switch(THREADID tid, Language lang);
+
+	// Called once per executed basic block, with its static counts. Makes no
+	// calls, so Pin can inline it.
+	static VOID Count(ThreadProfile* profile, UINT32 instructions, UINT32 memoryOps, UINT32 runtime) {
+		profile->blocks += 1;
+		profile->instructions[profile->lang][runtime] += instructions;
+		profile->memoryOps[profile->lang][runtime] += memoryOps;
+	}
+
+	// The instructions executed so far by every thread. Counters are read
+	// without synchronization, so the result is approximate.
+	UINT64 TotalInstructions();
+
+	// The basic blocks executed so far by every thread, like TotalInstructions.
+	UINT64 TotalBlocks();
+
+	VOID Report(ofstream& stream);
+};
+
+#endif // PROFILE_H
@@ -3,13 +3,14 @@
 #ifndef REGISTRY_H
 #define REGISTRY_H
 
-#include "pin.H"
+#include "platform.h"
 #include <string>
-#include <types.h>
+#include <vector>
 
 #include "language.h"
 
 using std::string;
+using std::vector;
 
 typedef struct Node {
     // Objects with starting addresses less than the key.
@@ -29,24 +30,81 @@ typedef struct Node {
 
 	// The language responsible for creating this object.
 	Language lang;
+
+    // The root of the objects nested in this one (e.g. the allocations of
+    // an arena inside the block it got from malloc).
+    struct Node *inner;
 } Node;
 
+// How lookups in the registry went.
+struct RegistryStats {
+    UINT64 lookups;
+
+    // The lookups that found no object.
+    UINT64 misses;
+
+    // The nodes visited by every lookup, and the most any lookup visited.
+    UINT64 visited;
+    UINT64 deepest;
+};
+
+// Maps address ranges to objects. Top-level objects never overlap, but every
+// object can hold nested objects inside its range, which can hold nested
+// objects in turn. Lookups resolve to the innermost object.
 class Registry {
 private:
     Node *root;
 
+    RegistryStats stats;
+
+    static Node *insertInto(Node *&tree, ADDRINT start, USIZE size, const string& object, Language lang, Node **replaced);
+
+    // Counts the nodes it visits in `visited`.
+    static Node *findIn(Node *tree, ADDRINT addr, UINT64 &visited);
+
+    static Node *removeFrom(Node *&tree, ADDRINT key);
+
+    // Appends the top-level objects of `tree` to `nodes` in address order.
+    static void flatten(Node *tree, vector<Node *> &nodes);
+
+    // Builds a balanced tree of `nodes[first, last)`, which are in order.
+    static Node *build(vector<Node *> &nodes, size_t first, size_t last);
+
 public:
     // Construct a new registry.
     Registry();
 
-    // Map address to object.
-    void insert(ADDRINT start, USIZE size, string object, Language lang);
+    // Map address to object. If an object already started at `start`, it is
+    // detached, with its nested objects, and returned in `replaced`.
+    Node *insert(ADDRINT start, USIZE size, string object, Language lang, Node **replaced);
+
+    // Map a range inside a registered object to a nested object, below the
+    // innermost object that contains the whole range. Returns nullptr if no
+    // object contains it. Replaces a nested object at `start` like insert.
+    Node *insertNested(ADDRINT start, USIZE size, string object, Language lang, Node **replaced);
 
-    // Find the object that contains `addr`.
+    // Find the innermost object that contains `addr`.
     Node *find(ADDRINT addr);
 
-    // Remove the mapping that uses `key` as its key. 
+    // Remove the top-level mapping that uses `key` as its key. The objects
+    // nested in it stay attached to the returned node.
     Node *remove(ADDRINT key);
+
+    // Remove the innermost nested mapping that uses `key` as its key.
+    Node *removeNested(ADDRINT key);
+
+    // Move the objects nested in `tree` by `delta` bytes, e.g. after the
+    // block holding them was moved by realloc.
+    static void shift(Node *tree, ADDRINT delta);
+
+    // Detach the top-level objects of `tree` that are not entirely inside
+    // [start, end) and append them to `outside`, e.g. after the block holding
+    // them shrank. Their nested objects stay attached to them.
+    static void clip(Node *&tree, ADDRINT start, ADDRINT end, vector<Node *> &outside);
+
+    const RegistryStats &lookups() {
+        return stats;
+    }
 };
 
 #endif // REGISTRY_H
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "platform.h"
+
+#include "language.h"
+#include "pattern.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::ofstream;
+using std::string;
+using std::vector;
+
+enum class ReportFormat {
+	TEXT,
+	CSV,
+	JSON,
+	COLUMNAR
+};
+
+BOOL ReportFormatFromString(const string& name, ReportFormat& format);
+
+// One row of the object table.
+struct ObjectRow {
+	// The name of the object.
+	const string* name;
+
+	// The call site that allocated the object. The CSV and JSON files show
+	// it relative to its image (see IMG_FindOffsetByAddress).
+	ADDRINT site;
+
+	// The language that allocated the object.
+	Language lang;
+
+	// The read and write counts, indexed by the language making the access.
+	const UINT64* reads;
+	const UINT64* writes;
+
+	// The sum of all reads and writes.
+	UINT64 total;
+
+	// How every language walked the object, or nullptr if accesses were not
+	// classified.
+	const AccessPattern* patterns;
+};
+
+// Sorts the rows by total accesses and writes the `top` hottest ones (or all
+// of them if `top` is 0). The text format is written to `report`, every other
+// format to its own file in `directory`.
+VOID WriteObjects(ofstream& report, ReportFormat format, const string& directory, vector<ObjectRow>& rows, USIZE top);
+
+#endif // REPORT_H
@@ -0,0 +1,38 @@
+#ifndef ROUTINE_H
+#define ROUTINE_H
+
+#include "platform.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+
+// The ID given to accesses made outside of any known routine.
+const UINT32 UNKNOWN_ROUTINE = 0;
+
+// Gives every routine a dense ID, so analysis routines can receive it as an
+// immediate instead of looking the routine up at runtime. IDs are handed out
+// while Pin's client lock is held (during instrumentation).
+class RoutineTable {
+private:
+	// Maps the address of every routine to its ID.
+	map<ADDRINT, UINT32> ids;
+
+	// Maps every ID to the name of its routine.
+	vector<string> names;
+
+public:
+	RoutineTable();
+
+#ifndef BALEEN_NO_PIN
+	UINT32 Id(RTN rtn);
+#endif
+
+	const string& Name(UINT32 id);
+};
+
+#endif // ROUTINE_H
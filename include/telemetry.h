@@ -0,0 +1,158 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "platform.h"
+
+#include <x86intrin.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::map;
+using std::ofstream;
+using std::pair;
+using std::string;
+using std::vector;
+
+// Waits longer than this many cycles count as contended, shorter ones are
+// the cost of taking a free lock.
+const UINT64 CONTENDED_CYCLES = 1000;
+
+// How often the lock of a tracker was taken, and how long threads waited
+// for it (only timed with -telemetry).
+struct LockStats {
+	BOOL timed;
+
+	UINT64 acquisitions;
+
+	// The acquisitions that waited longer than CONTENDED_CYCLES, and the
+	// cycles they waited.
+	UINT64 contended;
+	UINT64 waited;
+};
+
+// Takes `lock` for thread `tid` like PIN_GetLock, and counts it in `stats`.
+inline VOID AcquireLock(PIN_LOCK* lock, THREADID tid, LockStats& stats) {
+	if (!stats.timed) {
+		PIN_GetLock(lock, tid + 1);
+		stats.acquisitions++;
+		return;
+	}
+
+	UINT64 start = __rdtsc();
+	PIN_GetLock(lock, tid + 1);
+	UINT64 wait = __rdtsc() - start;
+
+	// Counted once the lock is held, so the counts are exact
+	stats.acquisitions++;
+
+	if (wait > CONTENDED_CYCLES) {
+		stats.contended++;
+		stats.waited += wait;
+	}
+}
+
+// The analysis routines whose calls are counted.
+enum class Analysis {
+	READ,
+	WRITE,
+	MALLOC,
+	REALLOC,
+	POSIX_MEMALIGN,
+	FREE,
+	MAPPING,
+	COPY,
+	TRANSITION,
+	MARKER,
+	BLOCK,
+	ESCAPE
+};
+
+const UINT32 ANALYSES = 12;
+
+string AnalysisToString(Analysis analysis);
+
+struct RegistryStats;
+
+// The calls a single thread made to every analysis routine.
+struct ThreadTelemetry {
+	UINT64 calls[ANALYSES];
+};
+
+// The time Baleen's instrumentation callbacks spent on an image.
+struct ImageTelemetry {
+	UINT64 nanoseconds;
+	UINT64 instructions;
+};
+
+// Measures Baleen's own overhead (with -telemetry): the calls to every
+// analysis routine, the registry lookups, the lock traffic of every tracker,
+// the bytes logged, the time spent instrumenting every image and the peak
+// memory of Pin and the tool.
+class Telemetry {
+private:
+	PIN_LOCK lock;
+	TLS_KEY key;
+
+	BOOL enabled;
+
+	// The counters of every thread that ever ran an analysis routine.
+	vector<ThreadTelemetry*> threads;
+
+	// The locks of the trackers, by tracker name.
+	vector<pair<string, const LockStats*>> locks;
+
+	const RegistryStats* registry;
+
+	map<string, ImageTelemetry> images;
+
+	UINT64 peakMemory;
+
+	// Calls of inlined analysis routines, which count themselves elsewhere.
+	UINT64 inlined[ANALYSES];
+
+	ThreadTelemetry* Thread(THREADID tid);
+
+public:
+	Telemetry();
+
+	// Enables telemetry and creates the thread-local storage key, after Pin
+	// is initialized.
+	VOID Initialize();
+
+	// Forgets what the parent process measured, in a forked child.
+	VOID AfterFork(THREADID tid);
+
+	BOOL Enabled() {
+		return enabled;
+	}
+
+	VOID Count(THREADID tid, Analysis analysis) {
+		if (!enabled) return;
+
+		Thread(tid)->calls[static_cast<UINT32>(analysis)]++;
+	}
+
+	// Adds `calls` to an analysis routine that Pin inlines (see Count).
+	VOID AddCalls(Analysis analysis, UINT64 calls) {
+		inlined[static_cast<UINT32>(analysis)] += calls;
+	}
+
+	// Times the lock of `tracker` from now on.
+	VOID AddLock(const string& tracker, LockStats& stats);
+
+	VOID AddRegistry(const RegistryStats& stats);
+
+	// Adds time spent instrumenting `instructions` instructions of `image`.
+	VOID Instrumented(const string& image, UINT64 nanoseconds, UINT64 instructions);
+
+	// Records the memory allocated by Pin and the tool, if it is a new peak.
+	VOID SampleMemory(UINT64 bytes);
+
+	VOID Report(ofstream& stream, UINT64 loggedBytes);
+};
+
+#endif // TELEMETRY_H
@@ -1,10 +1,13 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
-#include "pin.H"
+#include "platform.h"
+
+#include <vector>
 
 using std::string_view;
 using std::string;
+using std::vector;
 
 BOOL EndsWith(string_view s, string_view suffix);
 
@@ -12,4 +15,26 @@ string ExtractFileName(const string& fullPath);
 
 int Run(const char* command);
 
+// Prefixes a relative path with the current directory.
+string AbsolutePath(const string& path);
+
+UINT64 MonotonicNanoseconds();
+
+// The path of the file open as `fd`, or "fd <N>" if it can't be found.
+string FilePath(INT32 fd);
+
+// Sizes are bucketed by powers of two, from 16 bytes up to 1 MiB.
+const UINT32 SIZE_CLASSES = 18;
+
+UINT32 SizeClass(USIZE size);
+
+string SizeClassToString(UINT32 sizeClass);
+
+const ADDRINT PAGE_BYTES = 4096;
+
+// Finds the NUMA node that holds every page in `pages`, with one system call.
+// Nodes are -1 where the kernel can't tell (no NUMA support, or the page is
+// not mapped).
+VOID PageNodes(const vector<ADDRINT>& pages, vector<INT32>& nodes);
+
 #endif // UTILITIES_H
\ No newline at end of file
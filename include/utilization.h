@@ -0,0 +1,73 @@
+#ifndef UTILIZATION_H
+#define UTILIZATION_H
+
+#include "platform.h"
+
+#include "language.h"
+
+#include <vector>
+
+using std::vector;
+
+// Objects up to this size remember every byte that was accessed, bigger ones
+// only every cache line.
+const USIZE TOUCH_BYTE_LIMIT = 4096;
+
+const USIZE CACHE_LINE_BYTES = 64;
+
+// The parts of an object that were ever accessed, in units of a byte or of a
+// cache line (see TOUCH_BYTE_LIMIT). The bitmap is only allocated on the
+// first access, so objects that are never accessed cost nothing.
+class TouchMap {
+private:
+	USIZE size;
+	USIZE grain;
+
+	vector<UINT64> bits;
+
+public:
+	TouchMap();
+
+	// Changes the size of the object, dropping `dropped` bytes from its
+	// front (e.g. when the start of a mapping is unmapped). What was
+	// accessed in the bytes it keeps stays accessed.
+	VOID Resize(USIZE newSize, USIZE dropped);
+
+	// Marks `bytes` bytes from `offset` on as accessed.
+	VOID Touch(ADDRINT offset, USIZE bytes);
+
+	// Forgets every access, but not the size.
+	VOID Clear();
+
+	USIZE Size() const {
+		return size;
+	}
+
+	// The bytes that were never accessed. With cache line units, a line
+	// counts as accessed as a whole.
+	USIZE Untouched() const;
+};
+
+// The objects of one allocation site and language, and how much of them was
+// used.
+struct UtilizationGroup {
+	UINT64 objects;
+	UINT64 bytes;
+	UINT64 untouched;
+
+	// The objects that were written but never read, and their bytes.
+	UINT64 writeOnly;
+	UINT64 writeOnlyBytes;
+
+	// The objects that were only read after their first read, and their
+	// bytes, and how many of them the other language read.
+	UINT64 readOnly;
+	UINT64 readOnlyBytes;
+	UINT64 shared;
+
+	// Adds an object of `lang` with its touch map and access counts, and
+	// the writes it got after its first read.
+	VOID Add(Language lang, const TouchMap& touched, const UINT64 reads[], const UINT64 writes[], UINT64 lateWrites);
+};
+
+#endif // UTILIZATION_H
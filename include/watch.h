@@ -0,0 +1,72 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "platform.h"
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::ofstream;
+using std::string;
+using std::vector;
+
+// The number of objects that can be watched at the same time.
+const UINT32 WATCH_SLOTS = 4;
+
+// The ranges checked on every memory access in watch mode. It is a plain
+// global (see IsWatched in baleen.cpp) so Pin can inline the check, which
+// only loads them. Free slots have a size of 0, which no address is inside of.
+struct WatchedRanges {
+	std::atomic<ADDRINT> start[WATCH_SLOTS];
+	std::atomic<ADDRINT> size[WATCH_SLOTS];
+};
+
+// Fills the watched ranges with the objects whose names match the globs
+// given with -watch, as they are registered, moved and freed. It is only
+// called by ObjectTracker, with its lock held.
+//
+// The ranges are read without a lock. A slot is emptied before it is changed
+// and its size is written last, all with release stores, so a racing access
+// sees the old range, no range, or the new one. Slots are found by the name
+// of their object, since a nested object can start where its container does.
+class WatchList {
+private:
+	WatchedRanges& ranges;
+
+	vector<string> globs;
+
+	// The name of the object in every slot.
+	string names[WATCH_SLOTS];
+
+	// The objects that were watched, and the matching objects that found
+	// every slot taken.
+	UINT64 watched;
+	UINT64 dropped;
+
+	// The slot holding the object called `name`, or WATCH_SLOTS.
+	UINT32 Slot(const string& name);
+
+	VOID Set(UINT32 slot, ADDRINT addr, USIZE size);
+
+public:
+	WatchList(WatchedRanges& r);
+
+	// Sets the comma-separated globs of the names to watch.
+	VOID SetNames(const string& list);
+
+	BOOL Enabled() {
+		return !globs.empty();
+	}
+
+	VOID Add(const string& name, ADDRINT addr, USIZE size);
+
+	VOID Move(const string& name, ADDRINT addr, USIZE size);
+
+	VOID Remove(const string& name);
+
+	VOID Report(ofstream& stream);
+};
+
+#endif // WATCH_H
@@ -1,104 +1,383 @@
 #include "allocation.h"
 #include "logger.h"
+#include "utilities.h"
 
-AllocationTracker::AllocationTracker(Logger& l) : logger(l) {
+// Lifetimes are bucketed by powers of ten, starting below one microsecond.
+static const UINT32 LIFETIME_BUCKETS = 8;
+
+static const char* LIFETIME_LABELS[LIFETIME_BUCKETS] = {
+	"< 1us", "< 10us", "< 100us", "< 1ms", "< 10ms", "< 100ms", "< 1s", ">= 1s"
+};
+
+static UINT32 LifetimeBucket(UINT64 nanoseconds) {
+	UINT32 bucket = 0;
+	UINT64 limit = 1000;
+
+	while (bucket < LIFETIME_BUCKETS - 1 && nanoseconds >= limit) {
+		bucket += 1;
+		limit *= 10;
+	}
+
+	return bucket;
 }
 
-VOID AllocationTracker::Allocate(THREADID tid, UINT64 bytes, Language lang) {
-	allocations[lang] += bytes;
+AllocationTracker::AllocationTracker(Logger& l) : locks(), logger(l) {
+	start = MonotonicNanoseconds();
+	lastSample = 0;
+	interval = 10 * 1000 * 1000;
+
+	PIN_InitLock(&lock);
 }
 
-VOID AllocationTracker::BeforeMalloc(THREADID tid, UINT64 bytes, Language lang) {
-	PIN_GetLock(&lock, tid + 1);
+VOID AllocationTracker::Initialize() {
+	key = PIN_CreateThreadDataKey(nullptr);
+}
 
-	auto id = counter[tid]["malloc"]++;
-	pendingMalloc[tid] = { id, bytes };
+AllocationThread* AllocationTracker::Thread(THREADID tid) {
+	AllocationThread* thread = static_cast<AllocationThread*>(PIN_GetThreadData(key, tid));
 
-	PIN_ReleaseLock(&lock);
+	if (thread == nullptr) {
+		thread = new AllocationThread();
+		thread->tid = tid;
+
+		PIN_SetThreadData(key, thread, tid);
+
+		AcquireLock(&lock, tid, locks);
+		threads.push_back(thread);
+		PIN_ReleaseLock(&lock);
+	}
+
+	return thread;
+}
+
+VOID AllocationTracker::Push(THREADID tid, AllocationCall call, ADDRINT addr, USIZE size, ADDRINT site, Language lang) {
+	AllocationThread* thread = Thread(tid);
+
+	thread->pending.push_back({ call, thread->calls++, addr, size, site, lang });
+}
+
+BOOL AllocationTracker::Pop(AllocationThread* thread, AllocationCall call, PendingCall& pending) {
+	for (size_t i = thread->pending.size(); i > 0; i--) {
+		if (thread->pending[i - 1].call == call) {
+			pending = thread->pending[i - 1];
+			thread->pending.resize(i - 1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+VOID AllocationTracker::Allocated(UINT64 allocated[]) {
+	for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+		allocated[lang] = 0;
+	}
+
+	// Counters of other threads are read without synchronization, so the
+	// sums are approximate while the program runs
+	for (AllocationThread* thread : threads) {
+		for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+			allocated[lang] += thread->allocated[lang];
+		}
+	}
+}
+
+VOID AllocationTracker::StartTimeline() {
+	logger.Stream(LogSubject::TIMELINE) << "Time (ns), Live (Rust), Live (C), Peak (Rust), Peak (C)" << endl;
+}
+
+VOID AllocationTracker::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	// The child inherits the parent's heap, so the live blocks stay but
+	// everything the parent already counted is forgotten
+	lifetimes.clear();
+	peak = live;
+
+	// The other threads do not exist in the child
+	AllocationThread* thread = static_cast<AllocationThread*>(PIN_GetThreadData(key, tid));
+
+	for (AllocationThread* other : threads) {
+		if (other != thread) delete other;
+	}
+
+	threads.clear();
+
+	if (thread != nullptr) {
+		*thread = AllocationThread();
+		thread->tid = tid;
+		threads.push_back(thread);
+	}
+
+	start = MonotonicNanoseconds();
+	lastSample = 0;
+
+	// Inherited blocks are aged from the fork
+	for (auto& entry : blocks) {
+		entry.second.allocated = 0;
+	}
+
+	StartTimeline();
+}
+
+VOID AllocationTracker::SetTimelineInterval(UINT64 milliseconds) {
+	interval = milliseconds * 1000 * 1000;
+}
+
+VOID AllocationTracker::Sample(UINT64 now) {
+	logger.Stream(LogSubject::TIMELINE) << now << ", "
+		<< live[Language::RUST] << ", "
+		<< live[Language::C] << ", "
+		<< peak[Language::RUST] << ", "
+		<< peak[Language::C] << endl;
+
+	lastSample = now;
+}
+
+VOID AllocationTracker::Allocate(AllocationThread* thread, ADDRINT addr, UINT64 bytes, Language lang) {
+	UINT64 now = MonotonicNanoseconds() - start;
+
+	thread->allocated[static_cast<UINT32>(lang)] += bytes;
+
+	blocks[addr] = { bytes, lang, thread->tid, now };
+
+	live[lang] += bytes;
+	peak[lang] = std::max(peak[lang], live[lang]);
+
+	if (now - lastSample >= interval) {
+		Sample(now);
+	}
+}
+
+VOID AllocationTracker::Resize(THREADID, ADDRINT oldAddr, ADDRINT newAddr, UINT64 bytes) {
+	auto it = blocks.find(oldAddr);
+
+	if (it == blocks.end()) return;
+
+	// The block keeps its language, owner and allocation time
+	Block block = it->second;
+	blocks.erase(it);
+
+	live[block.lang] += bytes;
+	live[block.lang] -= block.size;
+	peak[block.lang] = std::max(peak[block.lang], live[block.lang]);
+
+	block.size = bytes;
+	blocks[newAddr] = block;
+}
+
+VOID AllocationTracker::Deallocate(THREADID tid, ADDRINT addr) {
+	auto it = blocks.find(addr);
+
+	if (it == blocks.end()) return;
+
+	UINT64 now = MonotonicNanoseconds() - start;
+	const Block& block = it->second;
+
+	UINT64 lifetime = now - block.allocated;
+	lifetimes[block.lang][SizeClass(block.size)][LifetimeBucket(lifetime)] += 1;
+
+	live[block.lang] -= block.size;
+
+	logger.Stream(LogSubject::MEMORY) << "[FREE] " << block.size
+		<< " bytes allocated by " << LanguageToString(block.lang)
+		<< " on thread " << block.owner
+		<< " were freed by thread " << tid
+		<< " after " << lifetime << " ns" << endl;
+
+	blocks.erase(it);
+
+	if (now - lastSample >= interval) {
+		Sample(now);
+	}
+}
+
+VOID AllocationTracker::BeforeMalloc(THREADID tid, UINT64 bytes, Language lang, ADDRINT site) {
+	Push(tid, AllocationCall::MALLOC, 0, bytes, site, lang);
 }
 
 VOID AllocationTracker::AfterMalloc(THREADID tid, ADDRINT returned, Language lang, ObjectTracker& objectTracker) {
-	PIN_GetLock(&lock, tid + 1);
+	AllocationThread* thread = Thread(tid);
+	PendingCall pending;
+
+	if (!Pop(thread, AllocationCall::MALLOC, pending)) return;
 
-	auto payload = pendingMalloc[tid];
+	AcquireLock(&lock, tid, locks);
 
 	if (returned != 0) {
-		USIZE size = payload.second;
-		Allocate(tid, size, lang);
+		Allocate(thread, returned, pending.size, lang);
 
 		// Register an object
-		objectTracker.RegisterObject(tid, returned, size, lang, 0);
+		objectTracker.RegisterObject(tid, returned, pending.size, lang, 0, pending.site);
 	} else {
-		logger.Stream(LogSubject::MEMORY) << "[AFTER MALLOC] [" << payload.first << "] 'malloc' failed" << endl;
+		logger.Stream(LogSubject::MEMORY) << "[AFTER MALLOC] [" << pending.id << "] 'malloc' failed" << endl;
 	}
 
 	PIN_ReleaseLock(&lock);
 }
 
-VOID AllocationTracker::BeforePosixMemalign(THREADID tid, ADDRINT memptr_addr, USIZE alignment, USIZE size, Language lang) {
-	PIN_GetLock(&lock, tid + 1);
-
-	auto id = counter[tid]["posix_memalign"]++;
-	pendingPosixMemalign[tid] = { id, memptr_addr, size };
-
-	PIN_ReleaseLock(&lock);
+VOID AllocationTracker::BeforePosixMemalign(THREADID tid, ADDRINT memptr_addr, USIZE, USIZE size, Language lang, ADDRINT site) {
+	Push(tid, AllocationCall::POSIX_MEMALIGN, memptr_addr, size, site, lang);
 }
 
-VOID AllocationTracker::AfterPosixMemalign(THREADID tid, ADDRINT memptr_addr, INT32 result, Language lang, ObjectTracker& objectTracker) {
-	PIN_GetLock(&lock, tid + 1);
+VOID AllocationTracker::AfterPosixMemalign(THREADID tid, ADDRINT, INT32 result, Language lang, ObjectTracker& objectTracker) {
+	AllocationThread* thread = Thread(tid);
+	PendingCall pending;
 
-	auto payload = pendingPosixMemalign[tid];
+	if (!Pop(thread, AllocationCall::POSIX_MEMALIGN, pending)) return;
+
+	AcquireLock(&lock, tid, locks);
 
 	if (result == 0) {  // posix_memalign returns 0 on success
 		ADDRINT returned;
-		PIN_SafeCopy(&returned, (VOID*)memptr_addr, sizeof(ADDRINT));
-		
-		USIZE size = get<2>(payload);
-		Allocate(tid, size, lang);
-		objectTracker.RegisterObject(tid, returned, size, lang, 0);
+		PIN_SafeCopy(&returned, (VOID*)pending.addr, sizeof(ADDRINT));
+
+		Allocate(thread, returned, pending.size, lang);
+		objectTracker.RegisterObject(tid, returned, pending.size, lang, 0, pending.site);
 	} else {
-		logger.Stream(LogSubject::MEMORY) << "[AFTER POSIX_MEMALIGN] [" << get<0>(payload) << "] 'posix_memalign' failed with code " << result << endl;
+		logger.Stream(LogSubject::MEMORY) << "[AFTER POSIX_MEMALIGN] [" << pending.id << "] 'posix_memalign' failed with code " << result << endl;
 	}
 
 	PIN_ReleaseLock(&lock);
 }
 
-VOID AllocationTracker::BeforeRealloc(THREADID tid, ADDRINT addr, USIZE size, Language lang) {
-	PIN_GetLock(&lock, tid + 1);
-
+VOID AllocationTracker::BeforeRealloc(THREADID tid, ADDRINT addr, USIZE size, Language lang, ADDRINT site) {
 	logger.Stream(LogSubject::MEMORY) << "[BEFORE REALLOC]" << endl;
 
-	auto id = counter[tid]["realloc"]++;
-	pendingRealloc[tid] = { id, addr, size };
-
-	PIN_ReleaseLock(&lock);
+	Push(tid, AllocationCall::REALLOC, addr, size, site, lang);
 }
 
 VOID AllocationTracker::AfterRealloc(THREADID tid, ADDRINT newAddr, ObjectTracker& objectTracker) {
-	PIN_GetLock(&lock, tid + 1);
+	AllocationThread* thread = Thread(tid);
+	PendingCall pending;
+
+	if (!Pop(thread, AllocationCall::REALLOC, pending)) return;
+
+	AcquireLock(&lock, tid, locks);
 
 	logger.Stream(LogSubject::MEMORY) << "[AFTER REALLOC]" << endl;
 
-	auto payload = pendingRealloc[tid];
+	ADDRINT oldAddr = pending.addr;
+	USIZE size = pending.size;
+	ADDRINT site = pending.site;
+	Language lang = pending.lang;
 
-	ADDRINT oldAddr = get<1>(payload);
-	USIZE size = get<2>(payload);
-	
-	objectTracker.MoveObject(tid, oldAddr, newAddr, size);
+	if (oldAddr == 0) {
+		// 'realloc(NULL, size)' behaves like 'malloc(size)'
+		if (newAddr != 0) {
+			Allocate(thread, newAddr, size, lang);
+			objectTracker.RegisterObject(tid, newAddr, size, lang, 0, site);
+		}
+	} else if (newAddr == 0) {
+		// 'realloc(ptr, 0)' may free the object, otherwise the old object is left untouched
+		if (size == 0) {
+			Deallocate(tid, oldAddr);
+			objectTracker.RemoveObject(tid, oldAddr);
+		} else {
+			logger.Stream(LogSubject::MEMORY) << "[AFTER REALLOC] [" << pending.id << "] 'realloc' failed" << endl;
+		}
+	} else {
+		Resize(tid, oldAddr, newAddr, size);
+
+		// Objects allocated before Baleen attached are not tracked, so their
+		// new block is tracked as a new object
+		if (!objectTracker.MoveObject(tid, oldAddr, newAddr, size, lang)) {
+			Allocate(thread, newAddr, size, lang);
+			objectTracker.RegisterObject(tid, newAddr, size, lang, 0, site);
+		}
+	}
 
 	PIN_ReleaseLock(&lock);
 }
 
 VOID AllocationTracker::BeforeFree(THREADID tid, ADDRINT addr, ObjectTracker& objectTracker) {
+	AcquireLock(&lock, tid, locks);
+
+	Deallocate(tid, addr);
 	objectTracker.RemoveObject(tid, addr);
+
+	PIN_ReleaseLock(&lock);
+}
+
+BOOL AllocationTracker::InAllocator(THREADID tid) {
+	AllocationThread* thread = static_cast<AllocationThread*>(PIN_GetThreadData(key, tid));
+	return thread != nullptr && !thread->pending.empty();
+}
+
+VOID AllocationTracker::Snapshot(THREADID tid, UINT64 allocated[], UINT64 current[], UINT64 highest[]) {
+	AcquireLock(&lock, tid, locks);
+
+	Allocated(allocated);
+
+	for (Language lang : { Language::RUST, Language::C }) {
+		UINT32 index = static_cast<UINT32>(lang);
+
+		current[index] = live[lang];
+		highest[index] = peak[lang];
+	}
+
+	PIN_ReleaseLock(&lock);
 }
 
 VOID AllocationTracker::Report(ofstream& stream) {
-	auto rustBytes = allocations[Language::RUST];
-	auto cBytes = allocations[Language::C];
+	UINT64 allocated[LANGUAGES];
+	Allocated(allocated);
+
+	auto rustBytes = allocated[static_cast<UINT32>(Language::RUST)];
+	auto cBytes = allocated[static_cast<UINT32>(Language::C)];
 
 	stream << endl << "--- Allocation Report ---" << endl;
 	stream << "Rust:   " << rustBytes << " bytes" << endl;
 	stream << "C:      " << cBytes << " bytes" << endl;
 	stream << "Total:  " << (rustBytes + cBytes) << " bytes" << endl;
+
+	stream << endl << "--- Live Heap Report ---" << endl;
+	stream << "Peak (Rust):  " << peak[Language::RUST] << " bytes" << endl;
+	stream << "Peak (C):     " << peak[Language::C] << " bytes" << endl;
+	stream << "Live (Rust):  " << live[Language::RUST] << " bytes at exit" << endl;
+	stream << "Live (C):     " << live[Language::C] << " bytes at exit" << endl;
+
+	// Close the timeline with the state at exit
+	Sample(MonotonicNanoseconds() - start);
+
+	// Blocks that were never freed are counted separately
+	map<Language, map<UINT32, UINT64>> leaked;
+
+	for (const auto& pair : blocks) {
+		leaked[pair.second.lang][SizeClass(pair.second.size)] += 1;
+	}
+
+	stream << endl << "--- Lifetime Report ---" << endl;
+	stream << "Language, Size Class";
+
+	for (UINT32 bucket = 0; bucket < LIFETIME_BUCKETS; bucket++) {
+		stream << ", " << LIFETIME_LABELS[bucket];
+	}
+
+	stream << ", Live at Exit" << endl;
+
+	for (Language lang : { Language::RUST, Language::C }) {
+		for (UINT32 sizeClass = 0; sizeClass < SIZE_CLASSES; sizeClass++) {
+			auto& histogram = lifetimes[lang][sizeClass];
+			UINT64 remaining = leaked[lang][sizeClass];
+
+			UINT64 total = remaining;
+
+			for (const auto& pair : histogram) {
+				total += pair.second;
+			}
+
+			if (total == 0) continue;
+
+			stream << LanguageToString(lang) << ", " << SizeClassToString(sizeClass);
+
+			for (UINT32 bucket = 0; bucket < LIFETIME_BUCKETS; bucket++) {
+				stream << ", " << histogram[bucket];
+			}
+
+			stream << ", " << remaining << endl;
+		}
+	}
+
+	stream << endl;
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "attach.h"
+
+#include <algorithm>
+#include <sstream>
+
+using std::endl;
+using std::hex;
+using std::dec;
+using std::ifstream;
+using std::istringstream;
+
+AttachTracker::AttachTracker() : attached(false), reads(), writes() {
+	PIN_InitLock(&lock);
+}
+
+VOID AttachTracker::Snapshot() {
+	attached = true;
+
+	ifstream maps("/proc/self/maps");
+	string line;
+
+	// The end of the previous region, if it was an anonymous guard page
+	ADDRINT guard = 0;
+
+	while (std::getline(maps, line)) {
+		istringstream fields(line);
+
+		string range, perms, offset, device, inode, path;
+		fields >> range >> perms >> offset >> device >> inode;
+		std::getline(fields >> std::ws, path);
+
+		size_t dash = range.find('-');
+		if (dash == string::npos) continue;
+
+		ADDRINT start = std::stoull(range.substr(0, dash), nullptr, 16);
+		ADDRINT end = std::stoull(range.substr(dash + 1), nullptr, 16);
+
+		BOOL guarded = start == guard;
+		guard = (path.empty() && perms.rfind("---", 0) == 0) ? end : 0;
+
+		// Only writable heap and anonymous memory can hold heap objects
+		if (perms.size() < 2 || perms[1] != 'w') continue;
+		if (!path.empty() && path != "[heap]") continue;
+
+		// Thread stacks sit right above their guard page (malloc arenas
+		// have their reserved part above them instead)
+		if (path.empty() && guarded) continue;
+
+		Region region;
+		region.start = start;
+		region.end = end;
+		region.name = path.empty() ? "[anonymous]" : path;
+
+		regions.push_back(region);
+	}
+
+	std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) {
+		return a.start < b.start;
+	});
+}
+
+VOID AttachTracker::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+		reads[lang] = 0;
+		writes[lang] = 0;
+	}
+}
+
+BOOL AttachTracker::Contains(ADDRINT addr) {
+	// Find the last region starting at or before `addr`
+	auto it = std::upper_bound(regions.begin(), regions.end(), addr, [](ADDRINT value, const Region& region) {
+		return value < region.start;
+	});
+
+	if (it == regions.begin()) return false;
+
+	--it;
+
+	return addr < it->end;
+}
+
+VOID AttachTracker::RecordRead(THREADID tid, ADDRINT addr, Language lang) {
+	if (!attached || !Contains(addr)) return;
+
+	PIN_GetLock(&lock, tid + 1);
+	reads[static_cast<UINT32>(lang)]++;
+	PIN_ReleaseLock(&lock);
+}
+
+VOID AttachTracker::RecordWrite(THREADID tid, ADDRINT addr, Language lang) {
+	if (!attached || !Contains(addr)) return;
+
+	PIN_GetLock(&lock, tid + 1);
+	writes[static_cast<UINT32>(lang)]++;
+	PIN_ReleaseLock(&lock);
+}
+
+VOID AttachTracker::Report(ofstream& stream) {
+	if (!attached) return;
+
+	UINT64 bytes = 0;
+
+	for (const Region& region : regions) {
+		bytes += region.end - region.start;
+	}
+
+	stream << "--- Attach Report ---" << endl;
+	stream << "Baleen attached to a running process. Objects allocated before it attached are untracked." << endl;
+	stream << "Untracked regions: " << regions.size() << " (" << bytes << " bytes)" << endl;
+	stream << "Reads (Rust), Reads (C), Writes (Rust), Writes (C)" << endl;
+
+	stream << reads[static_cast<UINT32>(Language::RUST)] << ", "
+		<< reads[static_cast<UINT32>(Language::C)] << ", "
+		<< writes[static_cast<UINT32>(Language::RUST)] << ", "
+		<< writes[static_cast<UINT32>(Language::C)] << endl;
+
+	stream << endl << "Region, Start, End, Bytes" << endl;
+
+	for (const Region& region : regions) {
+		stream << region.name << ", "
+			<< "0x" << hex << region.start << ", "
+			<< "0x" << region.end << dec << ", "
+			<< region.end - region.start << endl;
+	}
+
+	stream << endl;
+}
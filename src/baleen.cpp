@@ -1,3 +1,4 @@
+#include <atomic>
 #include <elf.h>
 #include <link.h>
 #include <cstdlib>
@@ -13,14 +14,96 @@
 #include "utilities.h"
 #include "registry.h"
 #include "object.h"
+#include "copy.h"
+#include "report.h"
+#include "routine.h"
+#include "profile.h"
+#include "attach.h"
+#include "exporter.h"
 #include "logger.h"
-#include "utilities.h"
+#include "filter.h"
+#include "mapping.h"
+#include "watch.h"
+#include "telemetry.h"
+#include "escape.h"
 
 using std::cerr;
 using std::string;
 using std::set;
 using std::pair;
 using std::endl;
+using std::vector;
+
+KNOB<UINT64> KnobTimelineInterval(KNOB_MODE_WRITEONCE, "pintool", "timeline_interval", "10",
+    "milliseconds between samples of the live heap timeline in timeline.csv");
+
+KNOB<UINT32> KnobHeavyHitters(KNOB_MODE_WRITEONCE, "pintool", "heavy_hitters", "0",
+    "fold freed objects into the N hottest allocation sites per language and size class (0 keeps every object)");
+
+KNOB<string> KnobFormat(KNOB_MODE_WRITEONCE, "pintool", "format", "text",
+    "format of the object table: text (in report.txt), csv, json or columnar");
+
+KNOB<UINT32> KnobTop(KNOB_MODE_WRITEONCE, "pintool", "top", "0",
+    "only report the N most accessed objects (0 reports every object)");
+
+KNOB<UINT32> KnobRoutinePairs(KNOB_MODE_WRITEONCE, "pintool", "routine_pairs", "20",
+    "number of routine/object pairs with the most accesses to report per language");
+
+KNOB<BOOL> KnobProfile(KNOB_MODE_WRITEONCE, "pintool", "profile", "1",
+    "count instructions, memory operations and time spent in each language");
+
+KNOB<string> KnobForeignFunctions(KNOB_MODE_WRITEONCE, "pintool", "foreign_functions", "",
+    "read the foreign functions from this file instead of running the Foreign Function Finder");
+
+KNOB<UINT32> KnobDuration(KNOB_MODE_WRITEONCE, "pintool", "duration", "0",
+    "write the report and detach after this many seconds (0 profiles until the program exits)");
+
+KNOB<UINT64> KnobInstructionBudget(KNOB_MODE_WRITEONCE, "pintool", "instruction_budget", "0",
+    "write the report and detach after roughly this many instructions (0 means no budget)");
+
+KNOB<UINT32> KnobLive(KNOB_MODE_WRITEONCE, "pintool", "live", "0",
+    "publish live counters to /dev/shm/baleen-<pid> every N milliseconds (0 disables them)");
+
+KNOB<BOOL> KnobFirstTouch(KNOB_MODE_WRITEONCE, "pintool", "first_touch", "0",
+    "record the thread and language that first touched every page of an object, and report objects mostly used by other threads");
+
+KNOB<BOOL> KnobPatterns(KNOB_MODE_WRITEONCE, "pintool", "patterns", "0",
+    "classify how every language walks every object (sequential, strided or random)");
+
+KNOB<string> KnobOutput(KNOB_MODE_WRITEONCE, "pintool", "output", ".baleen",
+    "directory for the logs and reports (followed child processes write to DIRECTORY/<pid>)");
+
+KNOB<UINT32> KnobParent(KNOB_MODE_WRITEONCE, "pintool", "parent", "0",
+    "set by Baleen on the child processes it follows to the PID of their parent");
+
+KNOB<string> KnobIncludeImages(KNOB_MODE_WRITEONCE, "pintool", "include_images", "",
+    "only instrument memory accesses in images matching these comma-separated globs (e.g. 'myapp,libfoo*')");
+
+KNOB<string> KnobExcludeImages(KNOB_MODE_WRITEONCE, "pintool", "exclude_images", "",
+    "never instrument memory accesses in images matching these comma-separated globs");
+
+KNOB<string> KnobIncludeRoutines(KNOB_MODE_WRITEONCE, "pintool", "include_routines", "",
+    "only instrument memory accesses in routines matching these comma-separated globs");
+
+KNOB<string> KnobExcludeRoutines(KNOB_MODE_WRITEONCE, "pintool", "exclude_routines", "",
+    "never instrument memory accesses in routines matching these comma-separated globs");
+
+KNOB<BOOL> KnobRuntime(KNOB_MODE_WRITEONCE, "pintool", "runtime", "0",
+    "also instrument memory accesses in runtime images and routines (ld.so, libm, libstdc++, _start, PLT stubs, ...)");
+
+KNOB<string> KnobWatch(KNOB_MODE_WRITEONCE, "pintool", "watch", "",
+    "only count accesses to objects whose names match these comma-separated globs, at most 4 at a time, with a check Pin inlines");
+
+KNOB<BOOL> KnobUtilization(KNOB_MODE_WRITEONCE, "pintool", "utilization", "0",
+    "record the bytes of every object that are accessed, and report unused bytes, write-only and read-only objects");
+
+KNOB<BOOL> KnobEscapes(KNOB_MODE_WRITEONCE, "pintool", "escapes", "0",
+    "record pointers to objects of one language stored into objects of the other");
+
+KNOB<BOOL> KnobTelemetry(KNOB_MODE_WRITEONCE, "pintool", "telemetry", "0",
+    "report Baleen's own overhead: analysis calls, registry lookups, lock waits, logged bytes, instrumentation time and peak memory");
+
+ReportFormat reportFormat = ReportFormat::TEXT;
 
 UINT32 use_fff = 0;
 set<string> foreign_functions;
@@ -38,6 +121,43 @@ Logger logger;
 AllocationTracker allocationTracker(logger);
 LanguageTracker languageTracker(logger);
 ObjectTracker objectTracker(logger);
+CopyTracker copyTracker(logger);
+RoutineTable routines;
+ExecutionProfiler profiler;
+AttachTracker attachTracker;
+LiveExporter liveExporter;
+InstrumentationFilter filter(logger);
+MappingTracker mappingTracker(logger);
+WatchedRanges watchedRanges;
+WatchList watchList(watchedRanges);
+Telemetry telemetry;
+HeapRegions heapRegions;
+EscapeTracker escapeTracker(logger);
+
+// The tool register that holds the profile of the running thread (with
+// -profile).
+REG profileRegister;
+
+// The internal thread that publishes live counters, and whether it was told
+// to stop (the process does not exit when Baleen detaches).
+PIN_THREAD_UID liveThread;
+std::atomic<BOOL> liveStopping(false);
+
+// The internal thread that samples the memory of Pin and the tool, and
+// whether it runs in this process (forked children do not inherit it).
+PIN_THREAD_UID telemetryThread;
+BOOL telemetrySampling = false;
+
+// The output directory of the first process, which holds one directory per
+// child process.
+string outputRoot;
+
+// The Pin command line before the application, for followed child processes.
+vector<string> pinArguments;
+
+// The absolute path of the foreign function list that was loaded, which
+// followed child processes reuse.
+string foreignFunctionsPath;
 
 INT32 Usage() {
     cerr << "Baleen 🐋" << endl;
@@ -45,69 +165,285 @@ INT32 Usage() {
     return -1;
 }
 
-VOID RecordMemRead(THREADID tid, ADDRINT ip, ADDRINT addr) {
+// The check in front of every memory access in watch mode. It has no calls
+// or branches, so Pin inlines it, and only accesses to a watched object pay
+// for the call to RecordMemRead or RecordMemWrite.
+static_assert(WATCH_SLOTS == 4, "IsWatched checks every slot by hand");
+
+ADDRINT PIN_FAST_ANALYSIS_CALL IsWatched(ADDRINT addr) {
+    return ((addr - watchedRanges.start[0].load(std::memory_order_relaxed)) < watchedRanges.size[0].load(std::memory_order_relaxed))
+        | ((addr - watchedRanges.start[1].load(std::memory_order_relaxed)) < watchedRanges.size[1].load(std::memory_order_relaxed))
+        | ((addr - watchedRanges.start[2].load(std::memory_order_relaxed)) < watchedRanges.size[2].load(std::memory_order_relaxed))
+        | ((addr - watchedRanges.start[3].load(std::memory_order_relaxed)) < watchedRanges.size[3].load(std::memory_order_relaxed));
+}
+
+// The check in front of every pointer store with -escapes. Only values in a
+// region that held a registered object can point to one.
+ADDRINT PIN_FAST_ANALYSIS_CALL IsHeapPointer(ADDRINT value) {
+    return (heapRegions.bits[(value >> HEAP_WORD_SHIFT) & (HEAP_REGION_WORDS - 1)] >> ((value >> HEAP_REGION_SHIFT) & 63)) & 1;
+}
+
+VOID RecordPointerStore(THREADID tid, ADDRINT ip, ADDRINT addr, ADDRINT value, UINT32 routine) {
+    telemetry.Count(tid, Analysis::ESCAPE);
+
     Language lang = languageTracker.GetCurrent(tid);
-    objectTracker.RecordRead(tid, addr, lang);
+    escapeTracker.Store(tid, ip, addr, value, lang, routine, objectTracker);
 }
 
-VOID RecordMemWrite(THREADID tid, ADDRINT ip, ADDRINT addr) {
+VOID RecordMemRead(THREADID tid, ADDRINT ip, ADDRINT addr, UINT32 size, UINT32 routine) {
+    telemetry.Count(tid, Analysis::READ);
+
+    Language lang = languageTracker.GetCurrent(tid);
+
+    if (!objectTracker.RecordRead(tid, addr, size, lang, routine)) {
+        attachTracker.RecordRead(tid, addr, lang);
+    }
+}
+
+VOID RecordMemWrite(THREADID tid, ADDRINT ip, ADDRINT addr, UINT32 size, UINT32 routine) {
+    telemetry.Count(tid, Analysis::WRITE);
+
     Language lang = languageTracker.GetCurrent(tid);
-    objectTracker.RecordWrite(tid, addr, lang);
+
+    if (!objectTracker.RecordWrite(tid, addr, size, lang, routine)) {
+        attachTracker.RecordWrite(tid, addr, lang);
+    }
 }
 
 VOID BeforeRust(THREADID tid, char* name) {
+    telemetry.Count(tid, Analysis::TRANSITION);
     logger.Stream(LogSubject::EXECUTION) << "[ENTER RUST] " << name << endl;
     languageTracker.Enter(tid, Language::RUST);
+    profiler.Switch(tid, Language::RUST);
 }
 
 VOID AfterRust(THREADID tid, char* name) {
+    telemetry.Count(tid, Analysis::TRANSITION);
     logger.Stream(LogSubject::EXECUTION) << "[EXIT RUST] " << name << endl;
-    languageTracker.Exit(tid);
+    profiler.Switch(tid, languageTracker.Exit(tid));
 }
 
 VOID BeforeC(THREADID tid, char* name) {
+    telemetry.Count(tid, Analysis::TRANSITION);
     logger.Stream(LogSubject::EXECUTION) << "[ENTER C] " << name << endl;
     languageTracker.Enter(tid, Language::C);
+    profiler.Switch(tid, Language::C);
 }
 
 VOID AfterC(THREADID tid, char* name) {
+    telemetry.Count(tid, Analysis::TRANSITION);
     logger.Stream(LogSubject::EXECUTION) << "[EXIT C] " << name << endl;
-    languageTracker.Exit(tid);
+    profiler.Switch(tid, languageTracker.Exit(tid));
 }
 
-VOID Instruction(INS ins, VOID *v) {
+// Runs before every basic block, so it makes no calls and Pin inlines it.
+// Telemetry gets the block count from the profiler when it reports.
+VOID PIN_FAST_ANALYSIS_CALL CountBlock(ThreadProfile* profile, UINT32 instructions, UINT32 memoryOps, UINT32 runtime) {
+    ExecutionProfiler::Count(profile, instructions, memoryOps, runtime);
+}
+
+VOID InstrumentTrace(TRACE trace) {
+    // Code in runtime images is counted separately from the program itself
+    IMG img = IMG_FindByAddress(TRACE_Address(trace));
+    UINT32 runtime = IMG_Valid(img) && IMG_IsRuntime(ExtractFileName(IMG_Name(img)));
+
+    for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+        UINT32 memoryOps = 0;
+
+        for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) {
+            memoryOps += INS_MemoryOperandCount(ins);
+        }
+
+        BBL_InsertCall(bbl, IPOINT_BEFORE, (AFUNPTR)CountBlock,
+            IARG_FAST_ANALYSIS_CALL,
+            IARG_REG_VALUE, profileRegister,
+            IARG_UINT32, BBL_NumIns(bbl),
+            IARG_UINT32, memoryOps,
+            IARG_UINT32, runtime,
+            IARG_END);
+    }
+}
+
+// The name telemetry files instrumentation time under, for code at `addr`.
+string TelemetryImage(ADDRINT addr) {
+    IMG img = IMG_FindByAddress(addr);
+    return IMG_Valid(img) ? ExtractFileName(IMG_Name(img)) : "[unknown]";
+}
+
+VOID Trace(TRACE trace, VOID *v) {
+    if (!telemetry.Enabled()) {
+        InstrumentTrace(trace);
+        return;
+    }
+
+    UINT64 start = MonotonicNanoseconds();
+    InstrumentTrace(trace);
+    telemetry.Instrumented(TelemetryImage(TRACE_Address(trace)), MonotonicNanoseconds() - start, 0);
+}
+
+VOID ThreadStart(THREADID tid, CONTEXT *ctxt, INT32 flags, VOID *v) {
+    ThreadProfile* profile = profiler.ThreadStart(tid);
+    PIN_SetContextReg(ctxt, profileRegister, reinterpret_cast<ADDRINT>(profile));
+}
+
+VOID ThreadFini(THREADID tid, const CONTEXT *ctxt, INT32 code, VOID *v) {
+    profiler.ThreadFini(tid);
+}
+
+VOID InstrumentAccess(INS ins, UINT32 memOp, AFUNPTR record, UINT32 routine) {
+    if (!watchList.Enabled()) {
+        INS_InsertPredicatedCall(
+            ins, IPOINT_BEFORE, record,
+            IARG_THREAD_ID,
+            IARG_INST_PTR,
+            IARG_MEMORYOP_EA, memOp,
+            IARG_UINT32, INS_MemoryOperandSize(ins, memOp),
+            IARG_UINT32, routine,
+            IARG_END);
+
+        return;
+    }
+
+    INS_InsertIfPredicatedCall(
+        ins, IPOINT_BEFORE, (AFUNPTR)IsWatched,
+        IARG_FAST_ANALYSIS_CALL,
+        IARG_MEMORYOP_EA, memOp,
+        IARG_END);
+
+    INS_InsertThenPredicatedCall(
+        ins, IPOINT_BEFORE, record,
+        IARG_THREAD_ID,
+        IARG_INST_PTR,
+        IARG_MEMORYOP_EA, memOp,
+        IARG_UINT32, INS_MemoryOperandSize(ins, memOp),
+        IARG_UINT32, routine,
+        IARG_END);
+}
+
+// Whether `ins` stores a general purpose register to memory outside the
+// stack, which is how pointers are stored. Pointers stored by copies or with
+// vector registers are not seen.
+BOOL IsPointerStore(INS ins) {
+    return INS_IsMov(ins)
+        && INS_IsMemoryWrite(ins)
+        && !INS_IsStackWrite(ins)
+        && INS_MemoryWriteSize(ins) == sizeof(ADDRINT)
+        && INS_OperandCount(ins) >= 2
+        && INS_OperandIsReg(ins, 1)
+        && REG_is_gr64(INS_OperandReg(ins, 1));
+}
+
+VOID InstrumentInstruction(INS ins) {
+    // Copy routines are recorded as a single event by their entry hook
+    RTN rtn = INS_Rtn(ins);
+
+    if (RTN_Valid(rtn) && copyTracker.IsRoutine(RTN_Address(rtn))) {
+        return;
+    }
+
+    // Excluded images and routines run without memory instrumentation
+    if (!filter.Instruction(ins)) {
+        return;
+    }
+
+    UINT32 routine = routines.Id(rtn);
+
     // Instrument memory reads/writes
     UINT32 memOperands = INS_MemoryOperandCount(ins);
     
     for (UINT32 memOp = 0; memOp < memOperands; memOp++) {
         if (INS_MemoryOperandIsRead(ins, memOp)) {
-            INS_InsertPredicatedCall(
-                ins, IPOINT_BEFORE, (AFUNPTR)RecordMemRead,
-                IARG_THREAD_ID,
-                IARG_INST_PTR,
-                IARG_MEMORYOP_EA, memOp,
-                IARG_END);
+            InstrumentAccess(ins, memOp, (AFUNPTR)RecordMemRead, routine);
         }
 
         if (INS_MemoryOperandIsWritten(ins, memOp)) {
-            INS_InsertPredicatedCall(
-                ins, IPOINT_BEFORE, (AFUNPTR)RecordMemWrite,
-                IARG_THREAD_ID,
-                IARG_INST_PTR,
-                IARG_MEMORYOP_EA, memOp,
-                IARG_END);
+            InstrumentAccess(ins, memOp, (AFUNPTR)RecordMemWrite, routine);
         }
     }
+
+    if (KnobEscapes.Value() && IsPointerStore(ins)) {
+        REG value = INS_OperandReg(ins, 1);
+
+        INS_InsertIfPredicatedCall(
+            ins, IPOINT_BEFORE, (AFUNPTR)IsHeapPointer,
+            IARG_FAST_ANALYSIS_CALL,
+            IARG_REG_VALUE, value,
+            IARG_END);
+
+        INS_InsertThenPredicatedCall(
+            ins, IPOINT_BEFORE, (AFUNPTR)RecordPointerStore,
+            IARG_THREAD_ID,
+            IARG_INST_PTR,
+            IARG_MEMORYWRITE_EA,
+            IARG_REG_VALUE, value,
+            IARG_UINT32, routine,
+            IARG_END);
+    }
 }
 
-VOID BeforeBaleen(THREADID tid, ADDRINT addr, ADDRINT size, ADDRINT name) {
+VOID Instruction(INS ins, VOID *v) {
+    if (!telemetry.Enabled()) {
+        InstrumentInstruction(ins);
+        return;
+    }
+
+    UINT64 start = MonotonicNanoseconds();
+    InstrumentInstruction(ins);
+    telemetry.Instrumented(TelemetryImage(INS_Address(ins)), MonotonicNanoseconds() - start, 1);
+}
+
+VOID BeforeBaleen(THREADID tid, ADDRINT site, ADDRINT addr, ADDRINT size, ADDRINT name) {
+    telemetry.Count(tid, Analysis::MARKER);
     Language lang = languageTracker.GetCurrent(tid);
-    objectTracker.RegisterObject(tid, addr, size, lang, name);
+    objectTracker.RegisterObject(tid, addr, size, lang, name, site);
+}
+
+VOID BeforeName(THREADID tid, UINT64 id, ADDRINT name) {
+    telemetry.Count(tid, Analysis::MARKER);
+    char buffer[256];
+    USIZE copied = PIN_SafeCopy(buffer, (void*)name, sizeof(buffer) - 1);
+    buffer[copied] = '\0';
+
+    objectTracker.NameObjects(tid, id, buffer);
+}
+
+// Batches are copied out of the program in chunks, so a huge batch needs no
+// huge buffer.
+const USIZE MARKER_CHUNK = 256;
+
+VOID BeforeRegister(THREADID tid, ADDRINT site, ADDRINT array, USIZE count) {
+    telemetry.Count(tid, Analysis::MARKER);
+    Language lang = languageTracker.GetCurrent(tid);
+    NestedObject nested[MARKER_CHUNK];
+
+    for (USIZE done = 0; done < count; done += MARKER_CHUNK) {
+        USIZE chunk = std::min(count - done, MARKER_CHUNK);
+        USIZE copied = PIN_SafeCopy(nested, (VOID*)(array + done * sizeof(NestedObject)), chunk * sizeof(NestedObject));
+
+        objectTracker.RegisterNested(tid, nested, copied / sizeof(NestedObject), lang, site);
+
+        if (copied < chunk * sizeof(NestedObject)) break;
+    }
+}
+
+VOID BeforeUnregister(THREADID tid, ADDRINT array, USIZE count) {
+    telemetry.Count(tid, Analysis::MARKER);
+    ADDRINT addrs[MARKER_CHUNK];
+
+    for (USIZE done = 0; done < count; done += MARKER_CHUNK) {
+        USIZE chunk = std::min(count - done, MARKER_CHUNK);
+        USIZE copied = PIN_SafeCopy(addrs, (VOID*)(array + done * sizeof(ADDRINT)), chunk * sizeof(ADDRINT));
+
+        objectTracker.UnregisterNested(tid, addrs, copied / sizeof(ADDRINT));
+
+        if (copied < chunk * sizeof(ADDRINT)) break;
+    }
 }
 
-VOID BeforeMalloc(THREADID tid, USIZE size) {
+VOID BeforeMalloc(THREADID tid, ADDRINT site, USIZE size) {
+    telemetry.Count(tid, Analysis::MALLOC);
     Language lang = languageTracker.GetCurrent(tid);
-    allocationTracker.BeforeMalloc(tid, size, lang);
+    allocationTracker.BeforeMalloc(tid, size, lang, site);
 }
 
 VOID AfterMalloc(THREADID tid, ADDRINT returned) {
@@ -115,9 +451,10 @@ VOID AfterMalloc(THREADID tid, ADDRINT returned) {
     allocationTracker.AfterMalloc(tid, returned, lang, objectTracker);
 }
 
-VOID BeforePosixMemalign(THREADID tid, ADDRINT memptr, USIZE alignment, USIZE size) {
+VOID BeforePosixMemalign(THREADID tid, ADDRINT site, ADDRINT memptr, USIZE alignment, USIZE size) {
+    telemetry.Count(tid, Analysis::POSIX_MEMALIGN);
     Language lang = languageTracker.GetCurrent(tid);
-    allocationTracker.BeforePosixMemalign(tid, memptr, alignment, size, lang);
+    allocationTracker.BeforePosixMemalign(tid, memptr, alignment, size, lang, site);
 }
 
 VOID AfterPosixMemalign(THREADID tid, ADDRINT memptr, INT32 result) {
@@ -125,9 +462,10 @@ VOID AfterPosixMemalign(THREADID tid, ADDRINT memptr, INT32 result) {
     allocationTracker.AfterPosixMemalign(tid, memptr, result, lang, objectTracker);
 }
 
-VOID BeforeRealloc(THREADID tid, ADDRINT addr, USIZE size) {
+VOID BeforeRealloc(THREADID tid, ADDRINT site, ADDRINT addr, USIZE size) {
+    telemetry.Count(tid, Analysis::REALLOC);
     Language lang = languageTracker.GetCurrent(tid);
-    allocationTracker.BeforeRealloc(tid, addr, size, lang);
+    allocationTracker.BeforeRealloc(tid, addr, size, lang, site);
 }
 
 VOID AfterRealloc(THREADID tid, ADDRINT addr) {
@@ -135,19 +473,101 @@ VOID AfterRealloc(THREADID tid, ADDRINT addr) {
 }
 
 VOID BeforeFree(THREADID tid, ADDRINT addr) {
+    telemetry.Count(tid, Analysis::FREE);
     allocationTracker.BeforeFree(tid, addr, objectTracker);
 }
 
-VOID InstrumentImage(IMG img, VOID *v) {
+VOID BeforeMmap(THREADID tid, ADDRINT site, USIZE size, INT32 prot, INT32 flags, INT32 fd) {
+    telemetry.Count(tid, Analysis::MAPPING);
+    Language lang = languageTracker.GetCurrent(tid);
+    mappingTracker.BeforeMmap(tid, size, prot, flags, fd, lang, site, allocationTracker.InAllocator(tid));
+}
+
+VOID AfterMmap(THREADID tid, ADDRINT returned) {
+    mappingTracker.AfterMmap(tid, returned, objectTracker);
+}
+
+VOID BeforeMunmap(THREADID tid, ADDRINT addr, USIZE size) {
+    telemetry.Count(tid, Analysis::MAPPING);
+    mappingTracker.BeforeMunmap(tid, addr, size, objectTracker);
+}
+
+VOID BeforeMremap(THREADID tid, ADDRINT addr, USIZE oldSize, USIZE size) {
+    telemetry.Count(tid, Analysis::MAPPING);
+    Language lang = languageTracker.GetCurrent(tid);
+    mappingTracker.BeforeMremap(tid, addr, oldSize, size, lang);
+}
+
+VOID AfterMremap(THREADID tid, ADDRINT returned) {
+    mappingTracker.AfterMremap(tid, returned, objectTracker);
+}
+
+VOID BeforeCopy(THREADID tid, ADDRINT site, UINT32 kind, ADDRINT dst, ADDRINT src, USIZE size, UINT32 checked) {
+    telemetry.Count(tid, Analysis::COPY);
+    Language lang = languageTracker.GetCurrent(tid);
+    copyTracker.Copy(tid, site, static_cast<CopyKind>(kind), dst, src, size, checked, lang, objectTracker, routines);
+}
+
+VOID BeforeFill(THREADID tid, ADDRINT site, ADDRINT dst, USIZE size, UINT32 checked) {
+    BeforeCopy(tid, site, static_cast<UINT32>(CopyKind::MEMSET), dst, 0, size, checked);
+}
+
+VOID InstrumentCopy(IMG img, RTN rtn) {
+    // Checked variants (e.g. '__memcpy_chk') call the real routine themselves
+    UINT32 checked = EndsWith(RTN_Name(rtn), "_chk");
+
+    if (RTN_IsMemset(rtn)) {
+        RTN_Instrument(img, rtn, IPOINT_BEFORE,
+                     (AFUNPTR) BeforeFill,
+                     IARG_THREAD_ID,
+                     IARG_RETURN_IP,
+                     IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // Destination
+                     IARG_FUNCARG_ENTRYPOINT_VALUE, 2,  // Size
+                     IARG_UINT32, checked);
+    } else {
+        CopyKind kind = RTN_IsMemmove(rtn) ? CopyKind::MEMMOVE : CopyKind::MEMCPY;
+
+        RTN_Instrument(img, rtn, IPOINT_BEFORE,
+                     (AFUNPTR) BeforeCopy,
+                     IARG_THREAD_ID,
+                     IARG_RETURN_IP,
+                     IARG_UINT32, static_cast<UINT32>(kind),
+                     IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // Destination
+                     IARG_FUNCARG_ENTRYPOINT_VALUE, 1,  // Source
+                     IARG_FUNCARG_ENTRYPOINT_VALUE, 2,  // Size
+                     IARG_UINT32, checked);
+    }
+
+    copyTracker.AddRoutine(RTN_Address(rtn));
+
+    logger.Stream(LogSubject::INSTRUMENTATION) << "(COPY) " << RTN_Name(rtn) << endl;
+}
+
+VOID InstrumentRoutines(IMG img) {
     logger.Stream(LogSubject::INSTRUMENTATION) << "Instrumenting image: " << IMG_Name(img) << endl;
 
+    BOOL isLibc = IMG_Name(img).find("libc") != string::npos;
+
+    // Routines of excluded images are still walked for language transitions
+    // and copies. Rust routines exported with #[no_mangle] are only found by
+    // their source file, so it is looked up in every image but the runtime
+    // ones, which hold no Rust code and are what makes walking slow
+    BOOL instrumented = filter.Image(img);
+    BOOL located = !IMG_IsRuntime(ExtractFileName(IMG_Name(img)));
+
     for (SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
         for (RTN rtn = SEC_RtnHead(sec); RTN_Valid(rtn); rtn = RTN_Next(rtn)) {
             string rtnName = RTN_Name(rtn);
 
+            // Hand out routine IDs in address order as images load
+            routines.Id(rtn);
+
             string file;
             INT32 line;
-            PIN_GetSourceLocation(RTN_Address(rtn), NULL, &line, &file);
+
+            if (located) {
+                PIN_GetSourceLocation(RTN_Address(rtn), NULL, &line, &file);
+            }
 
             if (EndsWith(file, ".rs") || RTN_IsRust(rtn)) {
                 logger.Stream(LogSubject::INSTRUMENTATION) << "(RUST) " << rtnName << endl;
@@ -166,10 +586,20 @@ VOID InstrumentImage(IMG img, VOID *v) {
                              IARG_THREAD_ID,
                              IARG_PTR, safe_name,
                              IARG_END);
-            } else {
+            } else if (instrumented) {
                 logger.Stream(LogSubject::INSTRUMENTATION) << "(NOT RUST) " << rtnName << endl;
             }
 
+            // Rust's 'copy_nonoverlapping' lowers to a call to libc's 'memcpy'.
+            // glibc's 'memcpy' is an IFUNC resolver that picks one of the
+            // implementations (e.g. '__memmove_avx_unaligned_erms'), so only
+            // the implementations copy, and the kind is taken from their name
+            BOOL copies = RTN_IsMemcpy(rtn) || RTN_IsMemmove(rtn) || RTN_IsMemset(rtn);
+
+            if (isLibc && copies && !RTN_IsIFuncResolver(rtn)) {
+                InstrumentCopy(img, rtn);
+            }
+
             if (foreign_functions.count(rtnName) > 0) {
                 // Store string for safe pointer usage
                 const char* safe_name = StoreString(rtnName);
@@ -194,14 +624,35 @@ VOID InstrumentImage(IMG img, VOID *v) {
     RTN_InstrumentByName(img, "baleen", IPOINT_BEFORE,
                          (AFUNPTR) BeforeBaleen,
                          IARG_THREAD_ID,
+                         IARG_RETURN_IP,
                          IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // Address
                          IARG_FUNCARG_ENTRYPOINT_VALUE, 1,  // Size
                          IARG_FUNCARG_ENTRYPOINT_VALUE, 2); // Name
 
-    if (IMG_Name(img).find("libc") != string::npos) {
+    RTN_InstrumentByName(img, "baleen_name", IPOINT_BEFORE,
+                         (AFUNPTR) BeforeName,
+                         IARG_THREAD_ID,
+                         IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // ID
+                         IARG_FUNCARG_ENTRYPOINT_VALUE, 1); // Name
+
+    RTN_InstrumentByName(img, "baleen_register", IPOINT_BEFORE,
+                         (AFUNPTR) BeforeRegister,
+                         IARG_THREAD_ID,
+                         IARG_RETURN_IP,
+                         IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // Objects
+                         IARG_FUNCARG_ENTRYPOINT_VALUE, 1); // Count
+
+    RTN_InstrumentByName(img, "baleen_unregister", IPOINT_BEFORE,
+                         (AFUNPTR) BeforeUnregister,
+                         IARG_THREAD_ID,
+                         IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // Addresses
+                         IARG_FUNCARG_ENTRYPOINT_VALUE, 1); // Count
+
+    if (isLibc) {
         RTN_InstrumentByName(img, "malloc", IPOINT_BEFORE,
                              (AFUNPTR) BeforeMalloc,
                              IARG_THREAD_ID,
+                             IARG_RETURN_IP,
                              IARG_FUNCARG_ENTRYPOINT_VALUE, 0);
         
         RTN_InstrumentByName(img, "malloc", IPOINT_AFTER,
@@ -212,6 +663,7 @@ VOID InstrumentImage(IMG img, VOID *v) {
         RTN_InstrumentByName(img, "realloc", IPOINT_BEFORE,
                              (AFUNPTR) BeforeRealloc,
                              IARG_THREAD_ID,
+                             IARG_RETURN_IP,
                              IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
                              IARG_FUNCARG_ENTRYPOINT_VALUE, 1);
         
@@ -228,6 +680,7 @@ VOID InstrumentImage(IMG img, VOID *v) {
 		RTN_InstrumentByName(img, "posix_memalign", IPOINT_BEFORE,
                              (AFUNPTR) BeforePosixMemalign,
                              IARG_THREAD_ID,
+                             IARG_RETURN_IP,
                              IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // memptr
                              IARG_FUNCARG_ENTRYPOINT_VALUE, 1,  // alignment
                              IARG_FUNCARG_ENTRYPOINT_VALUE, 2); // size
@@ -237,42 +690,262 @@ VOID InstrumentImage(IMG img, VOID *v) {
                              IARG_THREAD_ID,
                              IARG_FUNCARG_ENTRYPOINT_VALUE, 0, // memptr
                              IARG_FUNCRET_EXITPOINT_VALUE);    // result
+
+        RTN_InstrumentByName(img, "mmap", IPOINT_BEFORE,
+                             (AFUNPTR) BeforeMmap,
+                             IARG_THREAD_ID,
+                             IARG_RETURN_IP,
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 1,  // length
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 2,  // prot
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 3,  // flags
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 4); // fd
+
+        RTN_InstrumentByName(img, "mmap", IPOINT_AFTER,
+                             (AFUNPTR) AfterMmap,
+                             IARG_THREAD_ID,
+                             IARG_FUNCRET_EXITPOINT_VALUE);
+
+        RTN_InstrumentByName(img, "munmap", IPOINT_BEFORE,
+                             (AFUNPTR) BeforeMunmap,
+                             IARG_THREAD_ID,
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // addr
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 1); // length
+
+        RTN_InstrumentByName(img, "mremap", IPOINT_BEFORE,
+                             (AFUNPTR) BeforeMremap,
+                             IARG_THREAD_ID,
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 0,  // old_address
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 1,  // old_size
+                             IARG_FUNCARG_ENTRYPOINT_VALUE, 2); // new_size
+
+        RTN_InstrumentByName(img, "mremap", IPOINT_AFTER,
+                             (AFUNPTR) AfterMremap,
+                             IARG_THREAD_ID,
+                             IARG_FUNCRET_EXITPOINT_VALUE);
     }
 }
 
+VOID InstrumentImage(IMG img, VOID *v) {
+    if (!telemetry.Enabled()) {
+        InstrumentRoutines(img);
+        return;
+    }
+
+    UINT64 start = MonotonicNanoseconds();
+    InstrumentRoutines(img);
+    telemetry.Instrumented(ExtractFileName(IMG_Name(img)), MonotonicNanoseconds() - start, 0);
+}
+
 VOID PrintReport(INT32 code, VOID *v) {
-    ofstream report("./.baleen/report.txt");
+    // Publish the final counters before the segment goes away
+    liveExporter.Update(PIN_ThreadId(), allocationTracker, objectTracker, languageTracker, true);
+    liveExporter.Close();
+
+    ofstream report(logger.Path("report.txt"));
 
     allocationTracker.Report(report);
-    objectTracker.Report(report);
-    
+    languageTracker.Report(report);
+    objectTracker.Report(report, reportFormat, KnobTop.Value());
+    objectTracker.ReportHeavyHitters(report);
+    objectTracker.ReportRoutines(report, routines, KnobRoutinePairs.Value());
+    copyTracker.Report(report, routines);
+
+    mappingTracker.Report(report, objectTracker);
+
+    if (KnobEscapes.Value()) {
+        escapeTracker.Report(report, routines);
+    }
+
+    objectTracker.ReportReallocs(report);
+    objectTracker.ReportFirstTouch(report);
+    objectTracker.ReportUtilization(report);
+
+    if (KnobProfile.Value()) {
+        profiler.Report(report);
+    }
+
+    attachTracker.Report(report);
+    watchList.Report(report);
+
+    if (telemetry.Enabled()) {
+        telemetry.SampleMemory(PIN_MemoryAllocatedForPin());
+        telemetry.AddCalls(Analysis::BLOCK, profiler.TotalBlocks());
+        telemetry.Report(report, logger.Bytes());
+    }
+
     report.close();
 }
 
-int main(int argc, char *argv[]) {
-    // Create file to hold list of foreign functions
-    Run("touch .baleen/foreign-functions.txt");
+VOID StopLiveCounters(VOID *v);
 
-    // Run the foreign function finder (FFF) to generate a list of foreign functions
-    const char* command = "bfff --output .baleen/foreign-functions.txt >/dev/null 2>&1";
-    
-    int status = Run(command);
-    if (status == -1) {
-        std::cerr << "Failed to complete foreign function analysis" << std::endl;
-        exit(1);
-    } else if (WIFEXITED(status)) {
-        int exit_code = WEXITSTATUS(status);
-        if (exit_code != 0) {
-            std::cerr << "The Foreign Function Finder failed, please make sure it works manually" << std::endl;
-            exit(1);
+VOID Detach(VOID *v) {
+    // The report unmaps the segment the exporter writes to
+    StopLiveCounters(v);
+    PrintReport(0, v);
+    logger.CloseAll();
+}
+
+// Runs in an internal thread and detaches once the profiling window set by
+// -duration or -instruction_budget is over.
+VOID ProfilingWindow(VOID *v) {
+    UINT64 start = MonotonicNanoseconds();
+    UINT64 duration = static_cast<UINT64>(KnobDuration.Value()) * 1000 * 1000 * 1000;
+    UINT64 budget = KnobInstructionBudget.Value();
+
+    while (!PIN_IsProcessExiting()) {
+        PIN_Sleep(100);
+
+        BOOL expired = duration > 0 && MonotonicNanoseconds() - start >= duration;
+        BOOL exhausted = budget > 0 && profiler.TotalInstructions() >= budget;
+
+        if (expired || exhausted) {
+            logger.Stream(LogSubject::EXECUTION) << "[DETACH] Profiling window is over" << endl;
+            PIN_Detach();
+            return;
         }
-    } else {
-        std::cerr << "The Foreign Function Finder was interrupted unexpectedly" << std::endl;
-        exit(1);
     }
+}
+
+// Runs in an internal thread and refreshes the live counters.
+VOID ExportLiveCounters(VOID *v) {
+    THREADID tid = PIN_ThreadId();
+
+    while (!PIN_IsProcessExiting() && !liveStopping) {
+        PIN_Sleep(KnobLive.Value());
+
+        if (liveStopping) break;
+
+        liveExporter.Update(tid, allocationTracker, objectTracker, languageTracker, false);
+    }
+}
+
+VOID StopLiveCounters(VOID *v) {
+    // Forked children abandon the segment, and have no exporter thread
+    if (!liveExporter.IsOpen() || liveStopping.exchange(true)) return;
+
+    // Wait for the exporter to notice it has to stop
+    PIN_WaitForThreadTermination(liveThread, PIN_INFINITE_TIMEOUT, NULL);
+}
+
+// Runs in an internal thread and samples the memory of Pin and the tool.
+VOID SampleToolMemory(VOID *v) {
+    while (!PIN_IsProcessExiting()) {
+        telemetry.SampleMemory(PIN_MemoryAllocatedForPin());
+        PIN_Sleep(10);
+    }
+}
+
+VOID StopToolMemory(VOID *v) {
+    if (!telemetrySampling) return;
+
+    PIN_WaitForThreadTermination(telemetryThread, PIN_INFINITE_TIMEOUT, NULL);
+}
+
+// Runs in the parent before a fork. The child inherits the buffers of the
+// logs and closes them, so they are emptied first or the child would write
+// the parent's lines to the parent's files a second time.
+VOID BeforeFork(THREADID tid, const CONTEXT *ctxt, VOID *v) {
+    logger.Flush();
+}
+
+// Runs in the child after a fork. Only the forking thread survives, and the
+// trackers still hold everything the parent counted, so they are reset and
+// the child writes to a directory of its own.
+VOID ForkChild(THREADID tid, const CONTEXT *ctxt, VOID *v) {
+    logger.Open(outputRoot + "/" + std::to_string(PIN_GetPid()));
+    logger.Stream(LogSubject::EXECUTION) << "[PROCESS] Forked from " << getppid() << endl;
+
+    allocationTracker.AfterFork(tid);
+    objectTracker.AfterFork(tid);
+    languageTracker.AfterFork(tid);
+    copyTracker.AfterFork(tid);
+    profiler.AfterFork(tid);
+    attachTracker.AfterFork(tid);
+    mappingTracker.AfterFork(tid);
+    escapeTracker.AfterFork(tid);
+    telemetry.AfterFork(tid);
+
+    liveExporter.Abandon();
+    telemetrySampling = false;
+}
+
+// Runs before a child process is exec'd (with Pin's -follow_execv). The child
+// gets the same options, but writes to a directory of its own and reuses the
+// foreign functions found for the first process.
+BOOL FollowChild(CHILD_PROCESS child, VOID *v) {
+    static vector<string> arguments;
+    static vector<const char*> argv;
+
+    // Options that name the parent's files are replaced
+    static const set<string> replaced = { "-output", "-foreign_functions", "-parent" };
+
+    arguments.clear();
+
+    for (size_t i = 0; i < pinArguments.size(); i++) {
+        if (replaced.count(pinArguments[i]) > 0) {
+            i += 1;
+            continue;
+        }
+
+        arguments.push_back(pinArguments[i]);
+    }
+
+    arguments.push_back("-output");
+    arguments.push_back(outputRoot);
+
+    // Without a list the child runs the finder itself
+    if (!foreignFunctionsPath.empty()) {
+        arguments.push_back("-foreign_functions");
+        arguments.push_back(foreignFunctionsPath);
+    }
+
+    arguments.push_back("-parent");
+    arguments.push_back(std::to_string(PIN_GetPid()));
+
+    argv.clear();
+
+    for (const string& argument : arguments) {
+        argv.push_back(argument.c_str());
+    }
+
+    CHILD_PROCESS_SetPinCommandLine(child, argv.size(), argv.data());
+
+    return true;
+}
+
+BOOL LoadForeignFunctions() {
+    string path = KnobForeignFunctions.Value();
+
+    if (path.empty()) {
+        path = logger.Path("foreign-functions.txt");
+
+        // Create file to hold list of foreign functions
+        Run(("touch '" + path + "'").c_str());
+
+        // Run the foreign function finder (FFF) to generate a list of foreign functions
+        string command = "bfff --output '" + path + "' >/dev/null 2>&1";
+        
+        int status = Run(command.c_str());
+        if (status == -1) {
+            std::cerr << "Failed to complete foreign function analysis" << std::endl;
+            return false;
+        } else if (WIFEXITED(status)) {
+            int exit_code = WEXITSTATUS(status);
+            if (exit_code != 0) {
+                std::cerr << "The Foreign Function Finder failed, please make sure it works manually" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "The Foreign Function Finder was interrupted unexpectedly" << std::endl;
+            return false;
+        }
+    }
+
+    // The child may run in another directory, so remember the absolute path
+    foreignFunctionsPath = AbsolutePath(path);
 
     // Read the collected foreign functions
-    std::ifstream input_file(".baleen/foreign-functions.txt");
+    std::ifstream input_file(path);
     
     std::string line;
     while (std::getline(input_file, line)) {
@@ -283,6 +956,10 @@ int main(int argc, char *argv[]) {
     
     input_file.close();
 
+    return true;
+}
+
+int main(int argc, char *argv[]) {
     // Initialize Pin
 	PIN_InitSymbols();
     
@@ -290,11 +967,122 @@ int main(int argc, char *argv[]) {
         return Usage();
     }
 
+    for (int i = 0; i < argc && string(argv[i]) != "--"; i++) {
+        pinArguments.push_back(argv[i]);
+    }
+
+    // The first process writes to the output directory itself, followed
+    // children to a directory named after their PID inside it
+    outputRoot = AbsolutePath(KnobOutput.Value());
+
+    if (KnobParent.Value() == 0) {
+        logger.Open(outputRoot);
+    } else {
+        logger.Open(outputRoot + "/" + std::to_string(PIN_GetPid()));
+        logger.Stream(LogSubject::EXECUTION) << "[PROCESS] Exec'd by " << KnobParent.Value() << endl;
+    }
+
+    allocationTracker.Initialize();
+    mappingTracker.Initialize();
+    allocationTracker.StartTimeline();
+
+    if (!LoadForeignFunctions()) {
+        // Never take down a process we attached to
+        if (!PIN_IsAttaching()) {
+            exit(1);
+        }
+
+        cerr << "Continuing without foreign functions, C code will be attributed to its Rust caller" << endl;
+    }
+
+    if (PIN_IsAttaching()) {
+        attachTracker.Snapshot();
+    }
+
+    if (!ReportFormatFromString(KnobFormat.Value(), reportFormat)) {
+        cerr << "Unknown report format '" << KnobFormat.Value() << "'" << endl;
+        return Usage();
+    }
+
+    if (KnobInstructionBudget.Value() > 0 && !KnobProfile.Value()) {
+        cerr << "-instruction_budget needs -profile 1 to count instructions" << endl;
+        return Usage();
+    }
+
+    allocationTracker.SetTimelineInterval(KnobTimelineInterval.Value());
+    objectTracker.SetHeavyHitters(KnobHeavyHitters.Value());
+    objectTracker.SetFirstTouch(KnobFirstTouch.Value());
+    objectTracker.SetPatterns(KnobPatterns.Value());
+    objectTracker.SetUtilization(KnobUtilization.Value());
+
+    watchList.SetNames(KnobWatch.Value());
+
+    if (watchList.Enabled()) {
+        objectTracker.SetWatch(&watchList);
+    }
+
+    if (KnobEscapes.Value()) {
+        objectTracker.SetRegions(&heapRegions);
+    }
+
+    filter.SetImages(KnobIncludeImages.Value(), KnobExcludeImages.Value());
+    filter.SetRoutines(KnobIncludeRoutines.Value(), KnobExcludeRoutines.Value());
+    filter.SetRuntime(KnobRuntime.Value());
+
+    if (KnobTelemetry.Value()) {
+        telemetry.Initialize();
+        telemetry.AddLock("Allocation", allocationTracker.Locks());
+        telemetry.AddLock("Object", objectTracker.Locks());
+        telemetry.AddLock("Language", languageTracker.Locks());
+        telemetry.AddLock("Copy", copyTracker.Locks());
+        telemetry.AddLock("Mapping", mappingTracker.Locks());
+        telemetry.AddLock("Escape", escapeTracker.Locks());
+        telemetry.AddRegistry(objectTracker.Lookups());
+
+        telemetrySampling = PIN_SpawnInternalThread(SampleToolMemory, 0, 0, &telemetryThread) != INVALID_THREADID;
+        PIN_AddPrepareForFiniFunction(StopToolMemory, 0);
+    }
+
     IMG_AddInstrumentFunction(InstrumentImage, 0);
     INS_AddInstrumentFunction(Instruction, 0);
+
+    if (KnobProfile.Value()) {
+        profileRegister = PIN_ClaimToolRegister();
+
+        if (!REG_valid(profileRegister)) {
+            cerr << "Pin has no tool register left for -profile" << endl;
+            return Usage();
+        }
+
+        profiler.Initialize();
+
+        TRACE_AddInstrumentFunction(Trace, 0);
+        PIN_AddThreadStartFunction(ThreadStart, 0);
+        PIN_AddThreadFiniFunction(ThreadFini, 0);
+    }
+
     PIN_AddFiniFunction(PrintReport, 0);
+
+    PIN_AddForkFunction(FPOINT_BEFORE, BeforeFork, 0);
+    PIN_AddForkFunction(FPOINT_AFTER_IN_CHILD, ForkChild, 0);
+    PIN_AddFollowChildProcessFunction(FollowChild, 0);
+
+    if (KnobLive.Value() > 0) {
+        if (liveExporter.Open()) {
+            PIN_SpawnInternalThread(ExportLiveCounters, 0, 0, &liveThread);
+            PIN_AddPrepareForFiniFunction(StopLiveCounters, 0);
+        } else {
+            cerr << "Failed to create the live counter segment, continuing without it" << endl;
+        }
+    }
+
+    if (KnobDuration.Value() > 0 || KnobInstructionBudget.Value() > 0) {
+        // Fini functions do not run after detaching, so report on detach
+        PIN_AddDetachFunction(Detach, 0);
+        PIN_SpawnInternalThread(ProfilingWindow, 0, 0, NULL);
+    }
  
     PIN_StartProgram();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,164 @@
+#include "copy.h"
+
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+using std::pair;
+using std::make_tuple;
+using std::get;
+
+string CopyKindToString(CopyKind kind) {
+	switch (kind) {
+	case CopyKind::MEMCPY:
+		return "memcpy";
+	case CopyKind::MEMMOVE:
+		return "memmove";
+	default:
+		return "memset";
+	}
+}
+
+CopyTracker::CopyTracker(Logger& l) : locks(), logger(l) {
+}
+
+VOID CopyTracker::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	copies.clear();
+	checked.clear();
+}
+
+VOID CopyTracker::AddRoutine(ADDRINT addr) {
+	routines.insert(addr);
+}
+
+BOOL CopyTracker::IsRoutine(ADDRINT addr) {
+	return routines.count(addr) > 0;
+}
+
+UINT32 CopyTracker::SiteRoutine(ADDRINT site, RoutineTable& routines) {
+	auto it = sites.find(site);
+
+	if (it != sites.end()) {
+		return it->second;
+	}
+
+	PIN_LockClient();
+	UINT32 id = routines.Id(RTN_FindByAddress(site));
+	PIN_UnlockClient();
+
+	sites[site] = id;
+
+	return id;
+}
+
+VOID CopyTracker::Copy(THREADID tid, ADDRINT site, CopyKind kind, ADDRINT dst, ADDRINT src, USIZE bytes, BOOL isChecked, Language lang, ObjectTracker& objectTracker, RoutineTable& routines) {
+	if (bytes == 0) return;
+
+	AcquireLock(&lock, tid, locks);
+
+	// Checked variants (e.g. '__memcpy_chk') call the real routine, so only
+	// the first copy after one with the same arguments is that same copy.
+	// Repeating a copy without a checked variant counts every time.
+	auto current = make_tuple(dst, src, bytes);
+	auto previous = checked.find(tid);
+	BOOL inner = previous != checked.end() && previous->second == current;
+
+	if (previous != checked.end()) {
+		checked.erase(previous);
+	}
+
+	if (isChecked) {
+		checked[tid] = current;
+	}
+
+	if (inner) {
+		PIN_ReleaseLock(&lock);
+		return;
+	}
+
+	string srcName = "-";
+	string srcLang = "-";
+	string dstName = "?";
+	string dstLang = "?";
+
+	Language objectLang;
+	BOOL srcTracked = false;
+
+	if (kind != CopyKind::MEMSET) {
+		srcName = "?";
+		srcLang = "?";
+
+		srcTracked = objectTracker.Resolve(tid, src, srcName, objectLang);
+
+		if (srcTracked) {
+			srcLang = LanguageToString(objectLang);
+		}
+	}
+
+	BOOL dstTracked = objectTracker.Resolve(tid, dst, dstName, objectLang);
+
+	if (dstTracked) {
+		dstLang = LanguageToString(objectLang);
+	}
+
+	if (!srcTracked && !dstTracked) {
+		PIN_ReleaseLock(&lock);
+		return;
+	}
+
+	// The instructions inside copy routines are not instrumented, so the copy
+	// is counted as a single read of the source and a single write of the
+	// destination, made by the routine that called the copy
+	UINT32 routine = SiteRoutine(site, routines);
+
+	if (srcTracked) {
+		objectTracker.RecordRead(tid, src, bytes, lang, routine);
+	}
+
+	if (dstTracked) {
+		objectTracker.RecordWrite(tid, dst, bytes, lang, routine);
+	}
+
+	CopyStats& stats = copies[CopyKey(kind, srcName, dstName, srcLang, dstLang, site)];
+	stats.calls += 1;
+	stats.bytes += bytes;
+
+	logger.Stream(LogSubject::MEMORY) << "[" << CopyKindToString(kind) << "] " << bytes
+		<< " bytes from '" << srcName
+		<< "' (" << srcLang
+		<< ") to '" << dstName
+		<< "' (" << dstLang
+		<< ") at 0x" << hex << site << dec << endl;
+
+	PIN_ReleaseLock(&lock);
+}
+
+VOID CopyTracker::Report(ofstream& stream, RoutineTable& routines) {
+	vector<pair<CopyKey, CopyStats>> sorted(copies.begin(), copies.end());
+
+	// Show the copies that move the most data first
+	std::sort(sorted.begin(), sorted.end(), [](const pair<CopyKey, CopyStats>& a, const pair<CopyKey, CopyStats>& b) {
+		return a.second.bytes > b.second.bytes;
+	});
+
+	stream << "--- Copy Report ---" << endl;
+	stream << "Kind (Implementation), Source, Destination, Source Language, Destination Language, Site, Calls, Bytes" << endl;
+
+	for (const auto& entry : sorted) {
+		const CopyKey& key = entry.first;
+		ADDRINT site = get<5>(key);
+
+		stream << CopyKindToString(get<0>(key)) << ", "
+			<< get<1>(key) << ", "
+			<< get<2>(key) << ", "
+			<< get<3>(key) << ", "
+			<< get<4>(key) << ", "
+			<< "0x" << hex << site << dec << " (" << routines.Name(SiteRoutine(site, routines)) << "), "
+			<< entry.second.calls << ", "
+			<< entry.second.bytes << endl;
+	}
+
+	stream << endl;
+}
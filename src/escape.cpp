@@ -0,0 +1,89 @@
+#include "escape.h"
+
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+using std::pair;
+using std::get;
+
+EscapeTracker::EscapeTracker(Logger& l) : locks(), logger(l) {
+	PIN_InitLock(&lock);
+}
+
+VOID EscapeTracker::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	escapes.clear();
+}
+
+VOID EscapeTracker::Store(THREADID tid, ADDRINT site, ADDRINT addr, ADDRINT value, Language lang, UINT32 routine, ObjectTracker& objectTracker) {
+	string holder;
+	string pointee;
+	Language holderLang;
+	Language pointeeLang;
+
+	// Most values in the heap regions are not pointers at all, or point
+	// into freed memory, so the pointee is looked up first
+	if (!objectTracker.ResolvePointer(tid, addr, value, holder, holderLang, pointee, pointeeLang)) return;
+
+	if (holderLang == pointeeLang) return;
+
+	AcquireLock(&lock, tid, locks);
+
+	EscapeStats& stats = escapes[EscapeKey(holder, pointee, holderLang, pointeeLang, lang, site)];
+	stats.stores += 1;
+	stats.routine = routine;
+
+	logger.Stream(LogSubject::MEMORY) << "[ESCAPE] Pointer to '" << pointee
+		<< "' (" << LanguageToString(pointeeLang)
+		<< ") stored in '" << holder
+		<< "' (" << LanguageToString(holderLang)
+		<< ") at 0x" << hex << site << dec << endl;
+
+	PIN_ReleaseLock(&lock);
+}
+
+VOID EscapeTracker::Report(ofstream& stream, RoutineTable& routines) {
+	vector<pair<EscapeKey, EscapeStats>> sorted(escapes.begin(), escapes.end());
+
+	// Pointers to objects of one language held by objects of the other,
+	// indexed by the language of the pointee
+	UINT64 edges[LANGUAGES] = {};
+	UINT64 stores[LANGUAGES] = {};
+
+	for (const auto& entry : sorted) {
+		UINT32 index = static_cast<UINT32>(get<3>(entry.first));
+
+		edges[index] += 1;
+		stores[index] += entry.second.stores;
+	}
+
+	// Show the escapes stored the most first
+	std::sort(sorted.begin(), sorted.end(), [](const pair<EscapeKey, EscapeStats>& a, const pair<EscapeKey, EscapeStats>& b) {
+		return a.second.stores > b.second.stores;
+	});
+
+	UINT32 rust = static_cast<UINT32>(Language::RUST);
+	UINT32 c = static_cast<UINT32>(Language::C);
+
+	stream << endl << "--- Escape Report ---" << endl;
+	stream << "Rust Objects Held by C:  " << edges[rust] << " edges, " << stores[rust] << " stores" << endl;
+	stream << "C Objects Held by Rust:  " << edges[c] << " edges, " << stores[c] << " stores" << endl;
+
+	if (sorted.empty()) return;
+
+	stream << endl << "Holder, Holder Language, Pointee, Pointee Language, Stored By, Site, Stores" << endl;
+
+	for (const auto& entry : sorted) {
+		const EscapeKey& key = entry.first;
+
+		stream << get<0>(key) << ", "
+			<< LanguageToString(get<2>(key)) << ", "
+			<< get<1>(key) << ", "
+			<< LanguageToString(get<3>(key)) << ", "
+			<< LanguageToString(get<4>(key)) << ", "
+			<< "0x" << hex << get<5>(key) << dec << " (" << routines.Name(entry.second.routine) << "), "
+			<< entry.second.stores << endl;
+	}
+}
@@ -0,0 +1,119 @@
+#include "exporter.h"
+#include "utilities.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+using std::vector;
+
+static_assert(LIVE_LANGUAGES == LANGUAGES, "live.h must have a counter for every language");
+static_assert(LIVE_RUST == static_cast<UINT32>(Language::RUST), "live.h must index languages like Language");
+
+LiveExporter::LiveExporter() : counters(nullptr), start(0), lastUpdate(0), lastTransitions(0) {
+}
+
+BOOL LiveExporter::Open() {
+	// POSIX shared memory objects live in /dev/shm on Linux, which saves
+	// depending on librt inside the tool
+	path = "/dev/shm" LIVE_SEGMENT_PREFIX + std::to_string(PIN_GetPid());
+
+	int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+
+	if (fd < 0) return false;
+
+	if (ftruncate(fd, sizeof(LiveCounters)) != 0) {
+		close(fd);
+		return false;
+	}
+
+	void* memory = mmap(nullptr, sizeof(LiveCounters), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (memory == MAP_FAILED) return false;
+
+	counters = static_cast<LiveCounters*>(memory);
+	memset(counters, 0, sizeof(LiveCounters));
+
+	counters->magic = LIVE_MAGIC;
+	counters->version = LIVE_VERSION;
+	counters->pid = PIN_GetPid();
+
+	start = MonotonicNanoseconds();
+	lastUpdate = start;
+
+	return true;
+}
+
+VOID LiveExporter::Update(THREADID tid, AllocationTracker& allocationTracker, ObjectTracker& objectTracker, LanguageTracker& languageTracker, BOOL finished) {
+	if (!counters) return;
+
+	// Gather everything before touching the segment, so readers never wait
+	// on the trackers' locks
+	UINT64 allocated[LANGUAGES], live[LANGUAGES], peak[LANGUAGES];
+	UINT64 reads[LANGUAGES], writes[LANGUAGES];
+	vector<HotObject> hottest;
+
+	allocationTracker.Snapshot(tid, allocated, live, peak);
+	objectTracker.Snapshot(tid, LIVE_TOP_OBJECTS, reads, writes, hottest);
+	UINT64 transitions = languageTracker.Transitions(tid);
+
+	UINT64 now = MonotonicNanoseconds();
+	UINT64 elapsed = now - lastUpdate;
+	UINT64 rate = elapsed == 0 ? 0 : (transitions - lastTransitions) * 1000000000ULL / elapsed;
+
+	lastUpdate = now;
+	lastTransitions = transitions;
+
+	LiveBeginWrite(counters);
+
+	counters->updated = now - start;
+	counters->finished = finished;
+
+	for (UINT32 index = 0; index < LANGUAGES; index++) {
+		counters->allocated[index] = allocated[index];
+		counters->live[index] = live[index];
+		counters->peak[index] = peak[index];
+		counters->reads[index] = reads[index];
+		counters->writes[index] = writes[index];
+	}
+
+	counters->transitions = transitions;
+	counters->transitionRate = rate;
+
+	counters->objectCount = hottest.size();
+
+	for (USIZE i = 0; i < hottest.size(); i++) {
+		LiveObject& object = counters->objects[i];
+
+		strncpy(object.name, hottest[i].name.c_str(), LIVE_NAME_LENGTH - 1);
+		object.name[LIVE_NAME_LENGTH - 1] = '\0';
+
+		for (UINT32 index = 0; index < LANGUAGES; index++) {
+			object.reads[index] = hottest[i].reads[index];
+			object.writes[index] = hottest[i].writes[index];
+		}
+	}
+
+	LiveEndWrite(counters);
+}
+
+VOID LiveExporter::Abandon() {
+	if (!counters) return;
+
+	munmap(counters, sizeof(LiveCounters));
+
+	counters = nullptr;
+}
+
+VOID LiveExporter::Close() {
+	if (!counters) return;
+
+	munmap(counters, sizeof(LiveCounters));
+	unlink(path.c_str());
+
+	counters = nullptr;
+}
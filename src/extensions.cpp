@@ -1,5 +1,7 @@
 #include "extensions.h"
 
+#include <sstream>
+
 using std::isxdigit;
 
 BOOL IMG_IsVdso(IMG img) {
@@ -8,9 +10,7 @@ BOOL IMG_IsVdso(IMG img) {
     return names.count(imgName) > 0;
 }
 
-BOOL IMG_IsRuntime(string imgName) {
-	// string imgName = IMG_Name(img);
-
+const set<string>& RuntimeImages() {
 	static const set<string> images = {
 		"libc.so.6",
 		"libm.so.6",
@@ -21,12 +21,14 @@ BOOL IMG_IsRuntime(string imgName) {
 		"ld-linux-x86-64.so.2",
 	};
 
-	return images.count(imgName) > 0;
+	return images;
 }
 
-BOOL RTN_IsRuntime(RTN rtn) {
-	string name = RTN_Name(rtn);
+BOOL IMG_IsRuntime(string imgName) {
+	return RuntimeImages().count(imgName) > 0;
+}
 
+const set<string>& RuntimeRoutines() {
     static const set<string> names = {
         "_start",
 		"deregister_tm_clones",
@@ -45,7 +47,11 @@ BOOL RTN_IsRuntime(RTN rtn) {
 		"__rust_try"
     };
 
-    return names.count(name) > 0;
+    return names;
+}
+
+BOOL RTN_IsRuntime(RTN rtn) {
+    return RuntimeRoutines().count(RTN_Name(rtn)) > 0;
 }
 
 BOOL RTN_IsPLTStub(RTN rtn) {
@@ -82,4 +88,59 @@ BOOL RTN_IsRustLegacy(RTN rtn) {
 
 BOOL RTN_IsRust(RTN rtn) {
     return RTN_IsRustModern(rtn) || RTN_IsRustLegacy(rtn) || RTN_IsMain(rtn);
-}
\ No newline at end of file
+}
+
+// Strips the leading underscores glibc uses for its internal variants
+// (e.g. '__memmove_avx_unaligned_erms' or '__memcpy_chk').
+static string StripUnderscores(const string& name) {
+    size_t first = name.find_first_not_of('_');
+    return first == string::npos ? "" : name.substr(first);
+}
+
+BOOL RTN_IsMemcpy(RTN rtn) {
+    string name = StripUnderscores(RTN_Name(rtn));
+    return name.rfind("memcpy", 0) == 0 || name.rfind("mempcpy", 0) == 0;
+}
+
+BOOL RTN_IsMemmove(RTN rtn) {
+    string name = StripUnderscores(RTN_Name(rtn));
+    return name.rfind("memmove", 0) == 0;
+}
+
+BOOL RTN_IsMemset(RTN rtn) {
+    string name = StripUnderscores(RTN_Name(rtn));
+    return name.rfind("memset", 0) == 0;
+}
+
+BOOL RTN_IsIFuncResolver(RTN rtn) {
+    return SYM_IFuncResolver(RTN_Sym(rtn));
+}
+
+string RTN_FindNameByAddress(ADDRINT addr) {
+    PIN_LockClient();
+
+    RTN rtn = RTN_FindByAddress(addr);
+    string name = RTN_Valid(rtn) ? RTN_Name(rtn) : "?";
+
+    PIN_UnlockClient();
+
+    return name;
+}
+
+string IMG_FindOffsetByAddress(ADDRINT addr) {
+    std::ostringstream location;
+
+    PIN_LockClient();
+
+    IMG img = IMG_FindByAddress(addr);
+
+    if (IMG_Valid(img)) {
+        location << ExtractFileName(IMG_Name(img)) << "+0x" << std::hex << addr - IMG_LowAddress(img);
+    } else {
+        location << "0x" << std::hex << addr;
+    }
+
+    PIN_UnlockClient();
+
+    return location.str();
+}
@@ -0,0 +1,114 @@
+#include "filter.h"
+
+#include "extensions.h"
+#include "utilities.h"
+
+#include <fnmatch.h>
+#include <sstream>
+
+using std::endl;
+using std::istringstream;
+
+static vector<string> SplitGlobs(const string& list) {
+	vector<string> globs;
+	istringstream stream(list);
+	string glob;
+
+	while (std::getline(stream, glob, ',')) {
+		if (!glob.empty()) {
+			globs.push_back(glob);
+		}
+	}
+
+	return globs;
+}
+
+static BOOL Matches(const vector<string>& globs, const string& name, const string& path) {
+	for (const string& glob : globs) {
+		const string& target = glob.find('/') == string::npos ? name : path;
+
+		if (fnmatch(glob.c_str(), target.c_str(), 0) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+InstrumentationFilter::InstrumentationFilter(Logger& l) : logger(l), runtime(false) {
+}
+
+VOID InstrumentationFilter::SetImages(const string& included, const string& excluded) {
+	includedImages = SplitGlobs(included);
+	excludedImages = SplitGlobs(excluded);
+}
+
+VOID InstrumentationFilter::SetRoutines(const string& included, const string& excluded) {
+	includedRoutines = SplitGlobs(included);
+	excludedRoutines = SplitGlobs(excluded);
+}
+
+VOID InstrumentationFilter::SetRuntime(BOOL enabled) {
+	runtime = enabled;
+}
+
+BOOL InstrumentationFilter::Decide(const string& name, const string& path, const vector<string>& included, const vector<string>& excluded, BOOL isRuntime) {
+	if (Matches(excluded, name, path)) return false;
+
+	// An include list replaces the defaults
+	if (!included.empty()) return Matches(included, name, path);
+
+	return runtime || !isRuntime;
+}
+
+BOOL InstrumentationFilter::Image(IMG img) {
+	auto it = images.find(IMG_Id(img));
+
+	if (it != images.end()) {
+		return it->second;
+	}
+
+	string path = IMG_Name(img);
+	string name = ExtractFileName(path);
+	BOOL isRuntime = (IMG_IsRuntime(name) && name != "libc.so.6") || IMG_IsVdso(img);
+
+	BOOL instrumented = Decide(name, path, includedImages, excludedImages, isRuntime);
+	images[IMG_Id(img)] = instrumented;
+
+	if (!instrumented) {
+		logger.Stream(LogSubject::INSTRUMENTATION) << "(SKIPPED IMAGE) " << path << endl;
+	}
+
+	return instrumented;
+}
+
+BOOL InstrumentationFilter::Routine(RTN rtn) {
+	auto it = routines.find(RTN_Address(rtn));
+
+	if (it != routines.end()) {
+		return it->second;
+	}
+
+	string name = RTN_Name(rtn);
+	BOOL isRuntime = RTN_IsRuntime(rtn) || RTN_IsPLTStub(rtn);
+
+	BOOL instrumented = Image(SEC_Img(RTN_Sec(rtn)))
+		&& Decide(name, name, includedRoutines, excludedRoutines, isRuntime);
+
+	routines[RTN_Address(rtn)] = instrumented;
+
+	return instrumented;
+}
+
+BOOL InstrumentationFilter::Instruction(INS ins) {
+	RTN rtn = INS_Rtn(ins);
+
+	if (RTN_Valid(rtn)) {
+		return Routine(rtn);
+	}
+
+	// Code outside of any known routine is only filtered by its image
+	IMG img = IMG_FindByAddress(INS_Address(ins));
+
+	return !IMG_Valid(img) || Image(img);
+}
@@ -0,0 +1,50 @@
+#include "hitters.h"
+
+#include <algorithm>
+
+HeavyHitters::HeavyHitters(USIZE c) : capacity(c) {
+}
+
+VOID HeavyHitters::Add(ADDRINT key, UINT64 weight, const string& item) {
+	if (capacity == 0) return;
+
+	auto it = hitters.find(key);
+
+	if (it == hitters.end()) {
+		Hitter hitter = { weight, 0, 0, item, weight };
+
+		if (hitters.size() >= capacity) {
+			// Evict the lightest key and take over its count
+			auto lightest = std::min_element(hitters.begin(), hitters.end(), [](const auto& a, const auto& b) {
+				return a.second.count < b.second.count;
+			});
+
+			hitter.count += lightest->second.count;
+			hitter.error = lightest->second.count;
+
+			hitters.erase(lightest);
+		}
+
+		it = hitters.emplace(key, hitter).first;
+	} else {
+		it->second.count += weight;
+	}
+
+	Hitter& hitter = it->second;
+	hitter.items += 1;
+
+	if (weight > hitter.heaviestWeight) {
+		hitter.heaviest = item;
+		hitter.heaviestWeight = weight;
+	}
+}
+
+vector<pair<ADDRINT, Hitter>> HeavyHitters::Top() const {
+	vector<pair<ADDRINT, Hitter>> sorted(hitters.begin(), hitters.end());
+
+	std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+		return a.second.count > b.second.count;
+	});
+
+	return sorted;
+}
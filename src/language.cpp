@@ -10,8 +10,28 @@ string LanguageToString(Language lang) {
     }
 }
 
+VOID LanguageTracker::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	// Only the thread that called fork exists in the child
+	Language lang = language[tid];
+	stack<Language> stack = remembered[tid];
+
+	language.clear();
+	remembered.clear();
+
+	language[tid] = lang;
+	remembered[tid] = stack;
+
+	transitions = 0;
+
+	for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+		entered[lang] = 0;
+	}
+}
+
 Language LanguageTracker::GetCurrent(THREADID tid) {
-	PIN_GetLock(&lock, tid + 1);
+	AcquireLock(&lock, tid, locks);
 	Language lang = language[tid];
 	PIN_ReleaseLock(&lock);
 
@@ -19,7 +39,7 @@ Language LanguageTracker::GetCurrent(THREADID tid) {
 }
 
 VOID LanguageTracker::Enter(THREADID tid, Language newLang) {
-	PIN_GetLock(&lock, tid + 1);
+	AcquireLock(&lock, tid, locks);
 
 	// Get current language
 	Language curLang = language[tid];
@@ -30,17 +50,29 @@ VOID LanguageTracker::Enter(THREADID tid, Language newLang) {
 	// Update the new language
 	language[tid] = newLang;
 
+	if (curLang != newLang) {
+		transitions += 1;
+		entered[static_cast<UINT32>(newLang)] += 1;
+	}
+
 	logger.Stream(LogSubject::EXECUTION) << "[LANGUAGE] " << LanguageToString(curLang)
 		<< " → " << LanguageToString(newLang) << endl;
 
 	PIN_ReleaseLock(&lock);
 }
 
-VOID LanguageTracker::Exit(THREADID tid) {
-	PIN_GetLock(&lock, tid + 1);
+Language LanguageTracker::Exit(THREADID tid) {
+	AcquireLock(&lock, tid, locks);
 
 	// Get the current language and the language of our caller
 	Language curLang = language[tid];
+
+	// Functions entered before Baleen attached have nothing to restore
+	if (remembered[tid].empty()) {
+		PIN_ReleaseLock(&lock);
+		return curLang;
+	}
+
 	Language newLang = remembered[tid].top();
 
 	// Pop the current language since this function is done
@@ -49,8 +81,31 @@ VOID LanguageTracker::Exit(THREADID tid) {
 	// Set language back to what it was before function call
 	language[tid] = newLang;
 
+	if (curLang != newLang) {
+		transitions += 1;
+		entered[static_cast<UINT32>(newLang)] += 1;
+	}
+
 	logger.Stream(LogSubject::EXECUTION) << "[LANGUAGE] " << LanguageToString(curLang)
 		<< " → " << LanguageToString(newLang) << endl;
 
-	PIN_ReleaseLock(&lock);	
+	PIN_ReleaseLock(&lock);
+
+	return newLang;
+}
+
+UINT64 LanguageTracker::Transitions(THREADID tid) {
+	AcquireLock(&lock, tid, locks);
+	UINT64 count = transitions;
+	PIN_ReleaseLock(&lock);
+
+	return count;
+}
+
+VOID LanguageTracker::Report(ofstream& stream) {
+	stream << "--- Language Report ---" << endl;
+	stream << "Transitions (Rust to C):  " << entered[static_cast<UINT32>(Language::C)] << endl;
+	stream << "Transitions (C to Rust):  " << entered[static_cast<UINT32>(Language::RUST)] << endl;
+	stream << "Transitions:              " << transitions << endl;
+	stream << endl;
 }
\ No newline at end of file
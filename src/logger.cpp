@@ -8,15 +8,22 @@ using std::endl;
 
 Logger::Logger() {
     PIN_InitLock(&lock);
+}
+
+void Logger::Open(const string& dir) {
+    CloseAll();
 
-    Run("mkdir -p .baleen");
+    directory = dir;
+
+    Run(("mkdir -p '" + directory + "'").c_str());
     
     // Open log files for each subject
-    streams[LogSubject::INSTRUMENTATION].open(".baleen/instrumentation.log");
-    streams[LogSubject::EXECUTION].open(".baleen/execution.log");
-    streams[LogSubject::MEMORY].open(".baleen/memory.log");
-    streams[LogSubject::ACCESS].open(".baleen/access.log");
-    streams[LogSubject::OBJECTS].open(".baleen/objects.log");
+    streams[LogSubject::INSTRUMENTATION].open(Path("instrumentation.log"));
+    streams[LogSubject::EXECUTION].open(Path("execution.log"));
+    streams[LogSubject::MEMORY].open(Path("memory.log"));
+    streams[LogSubject::ACCESS].open(Path("access.log"));
+    streams[LogSubject::OBJECTS].open(Path("objects.log"));
+    streams[LogSubject::TIMELINE].open(Path("timeline.csv"));
     
     // Verify all streams opened successfully
     for (auto& pair : streams) {
@@ -27,6 +34,10 @@ Logger::Logger() {
     }
 }
 
+string Logger::Path(const string& file) {
+    return directory + "/" + file;
+}
+
 Logger::~Logger() {
     CloseAll();
 }
@@ -35,6 +46,31 @@ ofstream& Logger::Stream(LogSubject subject) {
     return streams[subject];
 }
 
+UINT64 Logger::Bytes() {
+    UINT64 bytes = 0;
+
+    for (auto& pair : streams) {
+        if (pair.second.is_open()) {
+            std::streamoff position = pair.second.tellp();
+            bytes += position > 0 ? position : 0;
+        }
+    }
+
+    return bytes;
+}
+
+void Logger::Flush() {
+    PIN_GetLock(&lock, PIN_ThreadId() + 1);
+
+    for (auto& pair : streams) {
+        if (pair.second.is_open()) {
+            pair.second.flush();
+        }
+    }
+
+    PIN_ReleaseLock(&lock);
+}
+
 void Logger::CloseAll() {
     PIN_GetLock(&lock, PIN_ThreadId() + 1);
     
@@ -0,0 +1,291 @@
+#include "mapping.h"
+#include "utilities.h"
+
+#include <sys/mman.h>
+
+#include <iterator>
+
+using std::endl;
+using std::hex;
+using std::dec;
+
+static const char* ANONYMOUS = "[anonymous]";
+
+MappingTracker::MappingTracker(Logger& l) : locks(), logger(l) {
+	PIN_InitLock(&lock);
+}
+
+VOID MappingTracker::Initialize() {
+	key = PIN_CreateThreadDataKey(nullptr);
+}
+
+MappingThread* MappingTracker::Thread(THREADID tid) {
+	MappingThread* thread = static_cast<MappingThread*>(PIN_GetThreadData(key, tid));
+
+	if (thread == nullptr) {
+		thread = new MappingThread();
+
+		PIN_SetThreadData(key, thread, tid);
+
+		AcquireLock(&lock, tid, locks);
+		threads.push_back(thread);
+		PIN_ReleaseLock(&lock);
+	}
+
+	return thread;
+}
+
+map<ADDRINT, Mapping>::iterator MappingTracker::Containing(ADDRINT addr) {
+	auto it = mappings.upper_bound(addr);
+
+	if (it == mappings.begin()) return mappings.end();
+
+	--it;
+
+	return addr < it->first + it->second.size ? it : mappings.end();
+}
+
+VOID MappingTracker::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	// The child inherits the parent's mappings, but not what they counted
+	unmapped.clear();
+
+	// The other threads do not exist in the child, and the forking thread
+	// is not inside a mapping call
+	MappingThread* thread = static_cast<MappingThread*>(PIN_GetThreadData(key, tid));
+
+	for (MappingThread* other : threads) {
+		if (other != thread) delete other;
+	}
+
+	threads.clear();
+
+	if (thread != nullptr) {
+		*thread = MappingThread();
+		threads.push_back(thread);
+	}
+
+	for (auto& entry : mappings) {
+		entry.second.mapped = entry.second.size;
+	}
+}
+
+VOID MappingTracker::Close(THREADID tid, Mapping& mapping, ObjectTracker& objectTracker) {
+	objectTracker.Counts(tid, mapping.name, mapping.reads, mapping.writes);
+	unmapped.push_back(mapping);
+}
+
+VOID MappingTracker::Unmap(THREADID tid, ADDRINT addr, USIZE size, ObjectTracker& objectTracker) {
+	ADDRINT end = addr + size;
+
+	// Start at the last mapping that begins before the range, it may reach into it
+	auto it = mappings.upper_bound(addr);
+
+	if (it != mappings.begin()) {
+		auto previous = std::prev(it);
+
+		if (previous->first + previous->second.size > addr) {
+			it = previous;
+		}
+	}
+
+	while (it != mappings.end() && it->first < end) {
+		ADDRINT start = it->first;
+		ADDRINT stop = start + it->second.size;
+		Mapping mapping = it->second;
+
+		it = mappings.erase(it);
+
+		if (addr <= start && end >= stop) {
+			logger.Stream(LogSubject::MEMORY) << "[MUNMAP] '" << mapping.name << "'" << endl;
+
+			Close(tid, mapping, objectTracker);
+			objectTracker.RemoveObject(tid, start);
+		} else if (start < addr) {
+			// The part below the hole keeps the object
+			objectTracker.ReshapeObject(tid, start, start, addr - start);
+
+			mapping.size = addr - start;
+			mappings[start] = mapping;
+
+			// The part above a hole in the middle becomes a mapping of its own
+			if (end < stop) {
+				Mapping upper = mapping;
+				upper.size = stop - end;
+				upper.mapped = 0;
+				upper.name = objectTracker.RegisterRegion(tid, end, upper.size, upper.lang,
+					upper.path.empty() ? ANONYMOUS : upper.path, upper.site);
+
+				mappings[end] = upper;
+			}
+		} else {
+			objectTracker.ReshapeObject(tid, start, end, stop - end);
+
+			mapping.size = stop - end;
+			mappings[end] = mapping;
+		}
+	}
+}
+
+VOID MappingTracker::BeforeMmap(THREADID tid, USIZE size, INT32 prot, INT32 flags, INT32 fd, Language lang, ADDRINT site, BOOL inAllocator) {
+	// Big heap blocks are tracked by the allocator hooks, thread stacks and
+	// code hold no objects, and reservations can't be accessed
+	BOOL tracked = !inAllocator
+		&& prot != PROT_NONE
+		&& (prot & PROT_EXEC) == 0
+		&& (flags & MAP_STACK) == 0;
+
+	string path = (flags & MAP_ANONYMOUS) != 0 ? "" : FilePath(fd);
+
+	Thread(tid)->mmaps.push_back({ 0, 0, size, path, lang, site, tracked });
+}
+
+VOID MappingTracker::AfterMmap(THREADID tid, ADDRINT returned, ObjectTracker& objectTracker) {
+	MappingThread* thread = Thread(tid);
+
+	if (thread->mmaps.empty()) return;
+
+	PendingMapping call = thread->mmaps.back();
+	thread->mmaps.pop_back();
+
+	if (returned == reinterpret_cast<ADDRINT>(MAP_FAILED)) return;
+
+	AcquireLock(&lock, tid, locks);
+
+	// A fixed mapping replaces whatever was mapped there
+	Unmap(tid, returned, call.size, objectTracker);
+
+	if (call.tracked) {
+		string name = objectTracker.RegisterRegion(tid, returned, call.size, call.lang,
+			call.path.empty() ? ANONYMOUS : call.path, call.site);
+
+		mappings[returned] = { name, call.path, call.size, call.lang, call.site, call.size, {}, {} };
+
+		logger.Stream(LogSubject::MEMORY) << "[MMAP] '" << name << "' maps " << call.size
+			<< " bytes at 0x" << hex << returned << dec << endl;
+	}
+
+	PIN_ReleaseLock(&lock);
+}
+
+VOID MappingTracker::BeforeMunmap(THREADID tid, ADDRINT addr, USIZE size, ObjectTracker& objectTracker) {
+	AcquireLock(&lock, tid, locks);
+	Unmap(tid, addr, size, objectTracker);
+	PIN_ReleaseLock(&lock);
+}
+
+VOID MappingTracker::BeforeMremap(THREADID tid, ADDRINT oldAddr, USIZE oldSize, USIZE size, Language lang) {
+	Thread(tid)->mremaps.push_back({ oldAddr, oldSize, size, "", lang, 0, true });
+}
+
+VOID MappingTracker::AfterMremap(THREADID tid, ADDRINT returned, ObjectTracker& objectTracker) {
+	MappingThread* thread = Thread(tid);
+
+	if (thread->mremaps.empty()) return;
+
+	PendingMapping call = thread->mremaps.back();
+	thread->mremaps.pop_back();
+
+	if (returned == reinterpret_cast<ADDRINT>(MAP_FAILED)) return;
+
+	AcquireLock(&lock, tid, locks);
+
+	// The old range can start anywhere inside a mapping
+	auto it = Containing(call.addr);
+
+	if (it != mappings.end()) {
+		Mapping mapping = it->second;
+
+		if (call.addr == it->first && call.oldSize == mapping.size) {
+			// Remapping a whole mapping is a realloc
+			mappings.erase(it);
+			objectTracker.MoveObject(tid, call.addr, returned, call.size, call.lang);
+
+			if (call.size > mapping.size) {
+				mapping.mapped += call.size - mapping.size;
+			}
+
+			mapping.size = call.size;
+			mappings[returned] = mapping;
+		} else {
+			// Part of a mapping moved or grew, the rest of it stays
+			Unmap(tid, call.addr, call.oldSize, objectTracker);
+
+			string name = objectTracker.RegisterRegion(tid, returned, call.size, mapping.lang,
+				mapping.path.empty() ? ANONYMOUS : mapping.path, mapping.site);
+
+			mappings[returned] = { name, mapping.path, call.size, mapping.lang, mapping.site, call.size, {}, {} };
+		}
+	}
+
+	PIN_ReleaseLock(&lock);
+}
+
+// The mappings of one source (a file, or anonymous memory) made by one language.
+struct MappingGroup {
+	UINT64 mappings;
+	UINT64 bytes;
+	UINT64 reads[LANGUAGES];
+	UINT64 writes[LANGUAGES];
+};
+
+VOID MappingTracker::Report(ofstream& stream, ObjectTracker& objectTracker) {
+	THREADID tid = PIN_ThreadId();
+
+	vector<Mapping> all = unmapped;
+
+	for (auto& entry : mappings) {
+		Mapping mapping = entry.second;
+		objectTracker.Counts(tid, mapping.name, mapping.reads, mapping.writes);
+		all.push_back(mapping);
+	}
+
+	map<pair<string, Language>, MappingGroup> groups;
+	UINT64 mapped[LANGUAGES] = {};
+
+	// Accesses made by the language that did not map the memory, split by
+	// file-backed and anonymous mappings
+	UINT64 crossed[2] = {};
+
+	for (const Mapping& mapping : all) {
+		MappingGroup& group = groups[{ mapping.path.empty() ? ANONYMOUS : mapping.path, mapping.lang }];
+		UINT32 owner = static_cast<UINT32>(mapping.lang);
+
+		group.mappings += 1;
+		group.bytes += mapping.mapped;
+		mapped[owner] += mapping.mapped;
+
+		for (UINT32 index = 0; index < LANGUAGES; index++) {
+			group.reads[index] += mapping.reads[index];
+			group.writes[index] += mapping.writes[index];
+
+			if (index != owner) {
+				crossed[mapping.path.empty()] += mapping.reads[index] + mapping.writes[index];
+			}
+		}
+	}
+
+	stream << endl << "--- Mapping Report ---" << endl;
+	stream << "Mapped (Rust):  " << mapped[static_cast<UINT32>(Language::RUST)] << " bytes" << endl;
+	stream << "Mapped (C):     " << mapped[static_cast<UINT32>(Language::C)] << " bytes" << endl;
+	stream << "Cross-Language (File-Backed):  " << crossed[0] << " accesses" << endl;
+	stream << "Cross-Language (Anonymous):    " << crossed[1] << " accesses" << endl;
+
+	if (groups.empty()) return;
+
+	stream << endl << "Source, Language, Mappings, Bytes, Reads (Rust), Writes (Rust), Reads (C), Writes (C)" << endl;
+
+	for (const auto& entry : groups) {
+		const MappingGroup& group = entry.second;
+
+		stream << entry.first.first << ", "
+			<< LanguageToString(entry.first.second) << ", "
+			<< group.mappings << ", "
+			<< group.bytes << ", "
+			<< group.reads[static_cast<UINT32>(Language::RUST)] << ", "
+			<< group.writes[static_cast<UINT32>(Language::RUST)] << ", "
+			<< group.reads[static_cast<UINT32>(Language::C)] << ", "
+			<< group.writes[static_cast<UINT32>(Language::C)] << endl;
+	}
+}
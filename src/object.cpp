@@ -1,4 +1,242 @@
 #include "object.h"
 
-ObjectTracker::ObjectTracker(Logger& l) : logger(l) {
-}
\ No newline at end of file
+ObjectTracker::ObjectTracker(Logger& l) : locks(), logger(l), totalReads(), totalWrites(), hitterCapacity(0), objectNumber(0), firstTouch(false), classify(false), utilization(false), watch(nullptr), regions(nullptr) {
+}
+VOID ObjectTracker::AfterFork(THREADID) {
+	PIN_InitLock(&lock);
+
+	// Live objects are inherited with their names, but their accesses and
+	// the parent's freed objects belong to the parent's report
+	for (auto it = stats.begin(); it != stats.end();) {
+		auto start = starts.find(it->first);
+
+		// Freed objects keep a start of 0 (see Release)
+		if (start == starts.end() || start->second == 0) {
+			if (start != starts.end()) {
+				starts.erase(start);
+			}
+
+			it = stats.erase(it);
+			continue;
+		}
+
+		for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+			it->second.reads[lang] = 0;
+			it->second.writes[lang] = 0;
+			it->second.routines[lang].clear();
+		}
+
+		it->second.pages.clear();
+		it->second.threads.clear();
+		it->second.touched.Clear();
+		it->second.lateWrites = 0;
+
+		for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+			it->second.patterns[lang] = AccessPattern();
+			it->second.walks[lang].clear();
+		}
+
+		++it;
+	}
+
+	for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+		totalReads[lang] = 0;
+		totalWrites[lang] = 0;
+	}
+
+	chains.clear();
+	foldedChains.clear();
+	folded.clear();
+	utilized.clear();
+}
+
+VOID ObjectTracker::ReportFirstTouch(ofstream& stream) {
+	if (!firstTouch) return;
+
+	struct Mismatch {
+		const string* name;
+		USIZE pages;
+		THREADID owner;
+		Language ownerLang;
+		INT32 node;
+		THREADID consumer;
+		Language consumerLang;
+		UINT64 consumed;
+		UINT64 accesses;
+		USIZE foreign;
+	};
+
+	vector<Mismatch> mismatches;
+	map<INT32, UINT64> nodes;
+	UINT64 touched = 0;
+
+	for (auto& pair : stats) {
+		// Live objects are placed now, freed ones were placed when freed
+		Place(pair.second);
+
+		const ObjectStats& counts = pair.second;
+
+		if (counts.pages.empty()) continue;
+
+		touched += 1;
+
+		// The owner is the thread that first touched the most pages
+		map<THREADID, USIZE> owned;
+		map<THREADID, array<USIZE, LANGUAGES>> ownedLangs;
+		map<INT32, USIZE> pageNodes;
+
+		for (const auto& page : counts.pages) {
+			owned[page.second.tid] += 1;
+			ownedLangs[page.second.tid][static_cast<UINT32>(page.second.lang)] += 1;
+			pageNodes[page.second.node] += 1;
+			nodes[page.second.node] += 1;
+		}
+
+		auto more = [](const auto& a, const auto& b) { return a.second < b.second; };
+
+		THREADID owner = std::max_element(owned.begin(), owned.end(), more)->first;
+		INT32 node = std::max_element(pageNodes.begin(), pageNodes.end(), more)->first;
+
+		const auto& ownerLangs = ownedLangs[owner];
+		Language ownerLang = ownerLangs[static_cast<UINT32>(Language::C)] > ownerLangs[static_cast<UINT32>(Language::RUST)] ? Language::C : Language::RUST;
+
+		// The consumer is the thread that made the most accesses
+		THREADID consumer = 0;
+		UINT64 consumed = 0;
+		UINT64 accesses = 0;
+		Language consumerLang = Language::RUST;
+
+		for (const auto& thread : counts.threads) {
+			UINT64 rust = thread.second[static_cast<UINT32>(Language::RUST)];
+			UINT64 c = thread.second[static_cast<UINT32>(Language::C)];
+
+			accesses += rust + c;
+
+			if (rust + c > consumed) {
+				consumer = thread.first;
+				consumed = rust + c;
+				consumerLang = c > rust ? Language::C : Language::RUST;
+			}
+		}
+
+		if (owner == consumer) continue;
+
+		USIZE foreign = counts.pages.size() - owned[consumer];
+
+		mismatches.push_back({ &pair.first, counts.pages.size(), owner, ownerLang, node, consumer, consumerLang, consumed, accesses, foreign });
+	}
+
+	// The objects the consumer hammers the most come first
+	std::sort(mismatches.begin(), mismatches.end(), [](const Mismatch& a, const Mismatch& b) {
+		return a.consumed > b.consumed;
+	});
+
+	stream << "--- First Touch Report ---" << endl;
+	stream << "Objects:     " << touched << endl;
+	stream << "Mismatched:  " << mismatches.size() << endl;
+
+	// Without NUMA support every page is on the same (unknown) node
+	if (nodes.size() == 1 && nodes.begin()->first == -1) {
+		stream << "Page nodes are unavailable, assuming a single node" << endl;
+	}
+
+	stream << endl << "Node, Pages" << endl;
+
+	for (const auto& pair : nodes) {
+		stream << (pair.first < 0 ? string("?") : std::to_string(pair.first)) << ", " << pair.second << endl;
+	}
+
+	stream << endl << "Name, Pages, Owner Thread, Owner Language, Node, Consumer Thread, Consumer Language, Consumer Accesses (%), Pages Touched First by Others" << endl;
+
+	for (const Mismatch& mismatch : mismatches) {
+		stream << *mismatch.name << ", "
+			<< mismatch.pages << ", "
+			<< mismatch.owner << ", "
+			<< LanguageToString(mismatch.ownerLang) << ", "
+			<< (mismatch.node < 0 ? string("?") : std::to_string(mismatch.node)) << ", "
+			<< mismatch.consumer << ", "
+			<< LanguageToString(mismatch.consumerLang) << ", "
+			<< (mismatch.accesses == 0 ? 0 : 100 * mismatch.consumed / mismatch.accesses) << ", "
+			<< mismatch.foreign << endl;
+	}
+
+	stream << endl;
+}
+
+VOID ObjectTracker::ReportUtilization(ofstream& stream) {
+	if (!utilization) return;
+
+	// Add the live objects to the freed ones
+	map<pair<ADDRINT, Language>, UtilizationGroup> groups = utilized;
+
+	for (const auto& pair : stats) {
+		auto start = starts.find(pair.first);
+
+		if (start == starts.end() || start->second == 0) continue;
+
+		const ObjectStats& counts = pair.second;
+		groups[{ counts.site, counts.lang }].Add(counts.lang, counts.touched, counts.reads, counts.writes, counts.lateWrites);
+	}
+
+	UtilizationGroup totals[LANGUAGES] = {};
+
+	for (const auto& entry : groups) {
+		UtilizationGroup& total = totals[static_cast<UINT32>(entry.first.second)];
+		const UtilizationGroup& group = entry.second;
+
+		total.objects += group.objects;
+		total.bytes += group.bytes;
+		total.untouched += group.untouched;
+		total.writeOnly += group.writeOnly;
+		total.writeOnlyBytes += group.writeOnlyBytes;
+		total.readOnly += group.readOnly;
+		total.readOnlyBytes += group.readOnlyBytes;
+		total.shared += group.shared;
+	}
+
+	vector<pair<pair<ADDRINT, Language>, UtilizationGroup>> sorted(groups.begin(), groups.end());
+
+	// Show the sites that waste the most bytes first
+	std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+		return a.second.untouched > b.second.untouched;
+	});
+
+	stream << "--- Utilization Report ---" << endl;
+
+	for (Language lang : { Language::RUST, Language::C }) {
+		const UtilizationGroup& total = totals[static_cast<UINT32>(lang)];
+		string label = " (" + LanguageToString(lang) + "):  ";
+
+		stream << "Allocated" << label
+			<< total.bytes << " bytes, "
+			<< total.untouched << " never accessed ("
+			<< (total.bytes == 0 ? 0 : 100 * total.untouched / total.bytes) << "%)" << endl;
+		stream << "Write-Only" << label
+			<< total.writeOnly << " objects, "
+			<< total.writeOnlyBytes << " bytes" << endl;
+		stream << "Read-Only" << label
+			<< total.readOnly << " objects, "
+			<< total.readOnlyBytes << " bytes, "
+			<< total.shared << " read by the other language" << endl;
+	}
+
+	stream << endl << "Site, Language, Objects, Bytes, Untouched Bytes, Write-Only Objects, Write-Only Bytes, Read-Only Objects, Read-Only Bytes, Read by Other Language" << endl;
+
+	for (const auto& entry : sorted) {
+		const UtilizationGroup& group = entry.second;
+
+		stream << "0x" << hex << entry.first.first << dec
+			<< " (" << RTN_FindNameByAddress(entry.first.first) << "), "
+			<< LanguageToString(entry.first.second) << ", "
+			<< group.objects << ", "
+			<< group.bytes << ", "
+			<< group.untouched << ", "
+			<< group.writeOnly << ", "
+			<< group.writeOnlyBytes << ", "
+			<< group.readOnly << ", "
+			<< group.readOnlyBytes << ", "
+			<< group.shared << endl;
+	}
+
+	stream << endl;
+}
@@ -0,0 +1,76 @@
+#include "pattern.h"
+
+string PatternToString(Pattern pattern) {
+	switch (pattern) {
+	case Pattern::SEQUENTIAL:
+		return "sequential";
+	case Pattern::STRIDED:
+		return "strided";
+	default:
+		return "random";
+	}
+}
+
+VOID AccessPattern::Record(Walk& walk, ADDRINT addr) {
+	// The first access of a walk has nothing to be compared to
+	if (!walk.started) {
+		walk.last = addr;
+		walk.stride = 0;
+		walk.started = true;
+		return;
+	}
+
+	INT64 stride = static_cast<INT64>(addr - walk.last);
+	Pattern pattern;
+
+	if (stride >= -SEQUENTIAL_BYTES && stride <= SEQUENTIAL_BYTES) {
+		pattern = Pattern::SEQUENTIAL;
+	} else if (stride == walk.stride) {
+		pattern = Pattern::STRIDED;
+	} else {
+		pattern = Pattern::RANDOM;
+	}
+
+	counts[static_cast<UINT32>(pattern)] += 1;
+
+	if (pattern != Pattern::RANDOM) {
+		strides[stride] += 1;
+	}
+
+	walk.last = addr;
+	walk.stride = stride;
+}
+
+BOOL AccessPattern::Empty() const {
+	for (UINT32 pattern = 0; pattern < PATTERNS; pattern++) {
+		if (counts[pattern] > 0) return false;
+	}
+
+	return true;
+}
+
+Pattern AccessPattern::Dominant() const {
+	UINT32 dominant = 0;
+
+	for (UINT32 pattern = 1; pattern < PATTERNS; pattern++) {
+		if (counts[pattern] > counts[dominant]) {
+			dominant = pattern;
+		}
+	}
+
+	return static_cast<Pattern>(dominant);
+}
+
+INT64 AccessPattern::Stride() const {
+	INT64 stride = 0;
+	UINT64 most = 0;
+
+	for (const auto& pair : strides) {
+		if (pair.second > most) {
+			stride = pair.first;
+			most = pair.second;
+		}
+	}
+
+	return stride;
+}
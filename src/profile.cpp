@@ -0,0 +1,187 @@
+#include "profile.h"
+#include "utilities.h"
+
+#include <iomanip>
+
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+static const char* KIND_LABELS[2] = { "Program", "Runtime" };
+
+static double Percent(UINT64 part, UINT64 whole) {
+	return whole == 0 ? 0.0 : 100.0 * part / whole;
+}
+
+ExecutionProfiler::ExecutionProfiler() : enabled(false) {
+	PIN_InitLock(&lock);
+}
+
+VOID ExecutionProfiler::Initialize() {
+	key = PIN_CreateThreadDataKey(nullptr);
+	enabled = true;
+}
+
+VOID ExecutionProfiler::Flush(ThreadProfile* profile, UINT64 now) {
+	profile->time[profile->lang] += now - profile->since;
+	profile->since = now;
+}
+
+VOID ExecutionProfiler::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	if (!enabled) return;
+
+	ThreadProfile* profile = static_cast<ThreadProfile*>(PIN_GetThreadData(key, tid));
+	UINT32 lang = profile->lang;
+
+	// The other threads do not exist in the child
+	for (ThreadProfile* other : threads) {
+		if (other != profile) delete other;
+	}
+
+	*profile = ThreadProfile();
+	profile->tid = tid;
+	profile->lang = lang;
+	profile->since = MonotonicNanoseconds();
+
+	threads.clear();
+	threads.push_back(profile);
+}
+
+ThreadProfile* ExecutionProfiler::ThreadStart(THREADID tid) {
+	ThreadProfile* profile = new ThreadProfile();
+	profile->tid = tid;
+	profile->lang = static_cast<UINT32>(Language::RUST);
+	profile->since = MonotonicNanoseconds();
+
+	PIN_SetThreadData(key, profile, tid);
+
+	PIN_GetLock(&lock, tid + 1);
+	threads.push_back(profile);
+	PIN_ReleaseLock(&lock);
+
+	return profile;
+}
+
+VOID ExecutionProfiler::ThreadFini(THREADID tid) {
+	ThreadProfile* profile = static_cast<ThreadProfile*>(PIN_GetThreadData(key, tid));
+
+	Flush(profile, MonotonicNanoseconds());
+	profile->finished = true;
+}
+
+VOID ExecutionProfiler::Switch(THREADID tid, Language lang) {
+	if (!enabled) return;
+
+	ThreadProfile* profile = static_cast<ThreadProfile*>(PIN_GetThreadData(key, tid));
+
+	Flush(profile, MonotonicNanoseconds());
+	profile->lang = static_cast<UINT32>(lang);
+}
+
+UINT64 ExecutionProfiler::TotalInstructions() {
+	UINT64 total = 0;
+
+	PIN_GetLock(&lock, PIN_ThreadId() + 1);
+
+	for (ThreadProfile* profile : threads) {
+		for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+			total += profile->instructions[lang][0] + profile->instructions[lang][1];
+		}
+	}
+
+	PIN_ReleaseLock(&lock);
+
+	return total;
+}
+
+UINT64 ExecutionProfiler::TotalBlocks() {
+	UINT64 total = 0;
+
+	PIN_GetLock(&lock, PIN_ThreadId() + 1);
+
+	for (ThreadProfile* profile : threads) {
+		total += profile->blocks;
+	}
+
+	PIN_ReleaseLock(&lock);
+
+	return total;
+}
+
+VOID ExecutionProfiler::Report(ofstream& stream) {
+	UINT64 now = MonotonicNanoseconds();
+
+	UINT64 instructions[LANGUAGES][2] = {};
+	UINT64 memoryOps[LANGUAGES][2] = {};
+	UINT64 time[LANGUAGES] = {};
+
+	UINT64 totalInstructions = 0;
+	UINT64 totalTime = 0;
+
+	for (ThreadProfile* profile : threads) {
+		// Threads that are still running have not been flushed yet
+		if (!profile->finished) {
+			Flush(profile, now);
+		}
+
+		for (UINT32 lang = 0; lang < LANGUAGES; lang++) {
+			for (UINT32 kind = 0; kind < 2; kind++) {
+				instructions[lang][kind] += profile->instructions[lang][kind];
+				memoryOps[lang][kind] += profile->memoryOps[lang][kind];
+				totalInstructions += profile->instructions[lang][kind];
+			}
+
+			time[lang] += profile->time[lang];
+			totalTime += profile->time[lang];
+		}
+	}
+
+	stream << "--- Execution Profile ---" << endl;
+	stream << "Language, Code, Instructions, Memory Ops, Instructions (%)" << endl;
+
+	std::streamsize precision = stream.precision();
+	stream << fixed << setprecision(2);
+
+	for (Language lang : { Language::RUST, Language::C }) {
+		UINT32 index = static_cast<UINT32>(lang);
+
+		for (UINT32 kind = 0; kind < 2; kind++) {
+			stream << LanguageToString(lang) << ", "
+				<< KIND_LABELS[kind] << ", "
+				<< instructions[index][kind] << ", "
+				<< memoryOps[index][kind] << ", "
+				<< Percent(instructions[index][kind], totalInstructions) << endl;
+		}
+	}
+
+	stream << endl << "Language, Time (ns), Time (%)" << endl;
+
+	for (Language lang : { Language::RUST, Language::C }) {
+		UINT32 index = static_cast<UINT32>(lang);
+
+		stream << LanguageToString(lang) << ", "
+			<< time[index] << ", "
+			<< Percent(time[index], totalTime) << endl;
+	}
+
+	stream << endl << "Thread, Language, Instructions (Program), Instructions (Runtime), Memory Ops, Time (ns)" << endl;
+
+	for (ThreadProfile* profile : threads) {
+		for (Language lang : { Language::RUST, Language::C }) {
+			UINT32 index = static_cast<UINT32>(lang);
+
+			stream << profile->tid << ", "
+				<< LanguageToString(lang) << ", "
+				<< profile->instructions[index][0] << ", "
+				<< profile->instructions[index][1] << ", "
+				<< profile->memoryOps[index][0] + profile->memoryOps[index][1] << ", "
+				<< profile->time[index] << endl;
+		}
+	}
+
+	stream.unsetf(std::ios::floatfield);
+	stream.precision(precision);
+	stream << endl;
+}
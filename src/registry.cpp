@@ -2,9 +2,12 @@
 
 #include "registry.h"
 
-Registry::Registry() : root(nullptr) {}
+#include <algorithm>
+#include <utility>
 
-void Registry::insert(ADDRINT start, USIZE size, string object, Language lang) {
+Registry::Registry() : root(nullptr), stats() {}
+
+Node *Registry::insertInto(Node *&tree, ADDRINT start, USIZE size, const string& object, Language lang, Node **replaced) {
     // Create the new node
     Node *newNode = new Node;
     newNode->left = nullptr;
@@ -13,15 +16,16 @@ void Registry::insert(ADDRINT start, USIZE size, string object, Language lang) {
     newNode->start = start;
     newNode->size = size;
 	newNode->lang = lang;
+    newNode->inner = nullptr;
     
     // If tree is empty, set as root
-    if (root == nullptr) {
-        root = newNode;
-        return;
+    if (tree == nullptr) {
+        tree = newNode;
+        return newNode;
     }
     
     // Standard BST insertion based on starting address
-    Node *current = root;
+    Node *current = tree;
     Node *parent = nullptr;
     
     while (current != nullptr) {
@@ -32,12 +36,15 @@ void Registry::insert(ADDRINT start, USIZE size, string object, Language lang) {
         } else if (start > current->start) {
             current = current->right;
         } else {
-            // Key already exists - could handle this differently
-            // For now, we'll just replace the existing node's data
-            current->name = object;
-            current->size = size;
-            delete newNode;
-            return;
+            // Key already exists, so the object there is stale. It keeps
+            // its place in the tree and hands its data, nested objects
+            // included, to the new node, which goes back to the caller
+            std::swap(current->name, newNode->name);
+            std::swap(current->size, newNode->size);
+            std::swap(current->lang, newNode->lang);
+            std::swap(current->inner, newNode->inner);
+            *replaced = newNode;
+            return current;
         }
     }
     
@@ -47,13 +54,46 @@ void Registry::insert(ADDRINT start, USIZE size, string object, Language lang) {
     } else {
         parent->right = newNode;
     }
+
+    return newNode;
 }
 
-// Find the object that contains `addr`.
-Node *Registry::find(ADDRINT addr) {
-    Node *current = root;
+Node *Registry::insert(ADDRINT start, USIZE size, string object, Language lang, Node **replaced) {
+    *replaced = nullptr;
+    return insertInto(root, start, size, object, lang, replaced);
+}
+
+Node *Registry::insertNested(ADDRINT start, USIZE size, string object, Language lang, Node **replaced) {
+    ADDRINT end = start + size;
+    *replaced = nullptr;
+    UINT64 visited = 0;
+    Node *container = findIn(root, start, visited);
+
+    if (container == nullptr || end > container->start + container->size) {
+        return nullptr;
+    }
+
+    // Descend while a nested object still contains the whole range. A
+    // nested object with the exact same range is replaced, not nested in
+    while (true) {
+        Node *nested = findIn(container->inner, start, visited);
+
+        if (nested == nullptr || end > nested->start + nested->size) break;
+        if (nested->start == start && nested->size == size) break;
+
+        container = nested;
+    }
+
+    return insertInto(container->inner, start, size, object, lang, replaced);
+}
+
+// Find the top-level object of `tree` that contains `addr`.
+Node *Registry::findIn(Node *tree, ADDRINT addr, UINT64 &visited) {
+    Node *current = tree;
     
     while (current != nullptr) {
+        visited += 1;
+
         ADDRINT start = current->start;
         ADDRINT end = start + current->size;
         
@@ -73,9 +113,30 @@ Node *Registry::find(ADDRINT addr) {
     return nullptr;
 }
 
-// Remove the mapping that uses `key` as its key.
-Node *Registry::remove(ADDRINT key) {
-    Node *current = root;
+// Find the innermost object that contains `addr`.
+Node *Registry::find(ADDRINT addr) {
+    UINT64 visited = 0;
+    Node *object = findIn(root, addr, visited);
+
+    while (object != nullptr && object->inner != nullptr) {
+        Node *nested = findIn(object->inner, addr, visited);
+
+        if (nested == nullptr) break;
+
+        object = nested;
+    }
+
+    stats.lookups += 1;
+    stats.misses += object == nullptr;
+    stats.visited += visited;
+    stats.deepest = std::max(stats.deepest, visited);
+
+    return object;
+}
+
+// Remove the top-level mapping of `tree` that uses `key` as its key.
+Node *Registry::removeFrom(Node *&tree, ADDRINT key) {
+    Node *current = tree;
     Node *parent = nullptr;
     
     // First, find the node to remove
@@ -100,7 +161,7 @@ Node *Registry::remove(ADDRINT key) {
     if (current->left == nullptr && current->right == nullptr) {
         if (parent == nullptr) {
             // Removing root with no children
-            root = nullptr;
+            tree = nullptr;
         } else if (parent->left == current) {
             parent->left = nullptr;
         } else {
@@ -112,7 +173,7 @@ Node *Registry::remove(ADDRINT key) {
     else if (current->left == nullptr) {
         if (parent == nullptr) {
             // Removing root
-            root = current->right;
+            tree = current->right;
         } else if (parent->left == current) {
             parent->left = current->right;
         } else {
@@ -124,7 +185,7 @@ Node *Registry::remove(ADDRINT key) {
     else if (current->right == nullptr) {
         if (parent == nullptr) {
             // Removing root
-            root = current->left;
+            tree = current->left;
         } else if (parent->left == current) {
             parent->left = current->left;
         } else {
@@ -143,10 +204,14 @@ Node *Registry::remove(ADDRINT key) {
             successor = successor->left;
         }
         
-        // Copy successor's data to current node
-        current->name = successor->name;
-        current->start = successor->start;
-        current->size = successor->size;
+        // Swap the data of the successor and the current node, so the
+        // current node takes the successor's place and the successor
+        // carries the removed object back to the caller
+        std::swap(current->name, successor->name);
+        std::swap(current->start, successor->start);
+        std::swap(current->size, successor->size);
+        std::swap(current->lang, successor->lang);
+        std::swap(current->inner, successor->inner);
         
         // Remove the successor node
         if (successorParent == current) {
@@ -155,9 +220,90 @@ Node *Registry::remove(ADDRINT key) {
             successorParent->left = successor->right;
         }
         
-        // Return the successor node (which has the old data)
+        // Return the successor node (which now has the removed data)
         nodeToReturn = successor;
     }
     
     return nodeToReturn;
-}
\ No newline at end of file
+}
+
+Node *Registry::remove(ADDRINT key) {
+    return removeFrom(root, key);
+}
+
+Node *Registry::removeNested(ADDRINT key) {
+    UINT64 visited = 0;
+    Node *container = findIn(root, key, visited);
+    Node *parent = nullptr;
+
+    // Find the innermost nested object that starts at `key`
+    while (container != nullptr) {
+        Node *nested = findIn(container->inner, key, visited);
+
+        if (nested == nullptr) break;
+
+        if (nested->start == key) {
+            parent = container;
+        }
+
+        container = nested;
+    }
+
+    if (parent == nullptr) {
+        return nullptr;
+    }
+
+    return removeFrom(parent->inner, key);
+}
+
+void Registry::shift(Node *tree, ADDRINT delta) {
+    if (tree == nullptr) return;
+
+    tree->start += delta;
+
+    shift(tree->left, delta);
+    shift(tree->right, delta);
+    shift(tree->inner, delta);
+}
+
+void Registry::flatten(Node *tree, vector<Node *> &nodes) {
+    if (tree == nullptr) return;
+
+    flatten(tree->left, nodes);
+    nodes.push_back(tree);
+    flatten(tree->right, nodes);
+}
+
+Node *Registry::build(vector<Node *> &nodes, size_t first, size_t last) {
+    if (first == last) return nullptr;
+
+    size_t middle = first + (last - first) / 2;
+    Node *node = nodes[middle];
+
+    node->left = build(nodes, first, middle);
+    node->right = build(nodes, middle + 1, last);
+
+    return node;
+}
+
+void Registry::clip(Node *&tree, ADDRINT start, ADDRINT end, vector<Node *> &outside) {
+    vector<Node *> nodes;
+    flatten(tree, nodes);
+
+    vector<Node *> inside;
+    size_t kept = outside.size();
+
+    for (Node *node : nodes) {
+        if (node->start >= start && node->start + node->size <= end) {
+            inside.push_back(node);
+        } else {
+            node->left = nullptr;
+            node->right = nullptr;
+            outside.push_back(node);
+        }
+    }
+
+    if (outside.size() == kept) return;
+
+    tree = build(inside, 0, inside.size());
+}
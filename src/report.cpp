@@ -0,0 +1,309 @@
+#include "report.h"
+#ifndef BALEEN_NO_PIN
+#include "extensions.h"
+#endif
+
+#include <algorithm>
+#include <map>
+
+using std::endl;
+using std::hex;
+using std::dec;
+using std::map;
+
+// Output files are written through a large buffer, so big tables reach the
+// disk in a few large writes.
+static const USIZE BUFFER_SIZE = 1 << 20;
+
+static const UINT32 RUST = static_cast<UINT32>(Language::RUST);
+static const UINT32 C = static_cast<UINT32>(Language::C);
+
+BOOL ReportFormatFromString(const string& name, ReportFormat& format) {
+	if (name == "text") {
+		format = ReportFormat::TEXT;
+	} else if (name == "csv") {
+		format = ReportFormat::CSV;
+	} else if (name == "json") {
+		format = ReportFormat::JSON;
+	} else if (name == "columnar") {
+		format = ReportFormat::COLUMNAR;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+// The dominant pattern of `lang` in `row`, or "-" if it made no accesses.
+static string PatternCell(const ObjectRow& row, UINT32 lang) {
+	const AccessPattern& pattern = row.patterns[lang];
+
+	return pattern.Empty() ? "-" : PatternToString(pattern.Dominant());
+}
+
+// The most common stride of `lang` in `row` in bytes, or "-" if it has none.
+static string StrideCell(const ObjectRow& row, UINT32 lang) {
+	INT64 stride = row.patterns[lang].Stride();
+
+	if (stride == 0) return "-";
+
+	return (stride > 0 ? "+" : "") + std::to_string(stride);
+}
+
+static VOID WriteText(ofstream& stream, const vector<ObjectRow>& rows, USIZE count) {
+	BOOL patterns = count > 0 && rows[0].patterns != nullptr;
+
+	stream << "--- Object Report ---" << endl;
+	stream << "Name, Reads (Rust), Reads (C), Writes (Rust), Writes (C)";
+
+	if (patterns) {
+		stream << ", Pattern (Rust), Stride (Rust), Pattern (C), Stride (C)";
+	}
+
+	stream << endl;
+
+	for (USIZE i = 0; i < count; i++) {
+		const ObjectRow& row = rows[i];
+
+		stream << *row.name << ", "
+			<< row.reads[RUST] << ", "
+			<< row.reads[C] << ", "
+			<< row.writes[RUST] << ", "
+			<< row.writes[C];
+
+		if (patterns) {
+			stream << ", " << PatternCell(row, RUST)
+				<< ", " << StrideCell(row, RUST)
+				<< ", " << PatternCell(row, C)
+				<< ", " << StrideCell(row, C);
+		}
+
+		stream << '\n';
+	}
+
+	stream << endl;
+}
+
+static VOID WriteCsvField(ofstream& stream, const string& value) {
+	if (value.find_first_of(",\"\n") == string::npos) {
+		stream << value;
+		return;
+	}
+
+	stream << '"';
+
+	for (char c : value) {
+		if (c == '"') {
+			stream << '"';
+		}
+
+		stream << c;
+	}
+
+	stream << '"';
+}
+
+static VOID WriteCsv(ofstream& stream, const vector<ObjectRow>& rows, const vector<string>& locations, USIZE count) {
+	BOOL patterns = count > 0 && rows[0].patterns != nullptr;
+
+	stream << "Name,Site,Language,Reads (Rust),Reads (C),Writes (Rust),Writes (C)";
+
+	if (patterns) {
+		stream << ",Pattern (Rust),Stride (Rust),Pattern (C),Stride (C)";
+	}
+
+	stream << '\n';
+
+	for (USIZE i = 0; i < count; i++) {
+		const ObjectRow& row = rows[i];
+
+		WriteCsvField(stream, *row.name);
+		stream << ",";
+		WriteCsvField(stream, locations[i]);
+
+		stream << ","
+			<< LanguageToString(row.lang) << ","
+			<< row.reads[RUST] << ","
+			<< row.reads[C] << ","
+			<< row.writes[RUST] << ","
+			<< row.writes[C];
+
+		if (patterns) {
+			stream << "," << PatternCell(row, RUST)
+				<< "," << StrideCell(row, RUST)
+				<< "," << PatternCell(row, C)
+				<< "," << StrideCell(row, C);
+		}
+
+		stream << '\n';
+	}
+}
+
+static VOID WriteJsonString(ofstream& stream, const string& value) {
+	stream << '"';
+
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			stream << '\\' << c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			stream << escaped;
+		} else {
+			stream << c;
+		}
+	}
+
+	stream << '"';
+}
+
+static VOID WriteJson(ofstream& stream, const vector<ObjectRow>& rows, const vector<string>& locations, USIZE count) {
+	stream << "{\"objects\":[";
+
+	for (USIZE i = 0; i < count; i++) {
+		const ObjectRow& row = rows[i];
+
+		stream << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+		WriteJsonString(stream, *row.name);
+
+		stream << ",\"site\":";
+		WriteJsonString(stream, locations[i]);
+
+		stream << ",\"language\":\"" << LanguageToString(row.lang) << "\""
+			<< ",\"reads\":{\"rust\":" << row.reads[RUST] << ",\"c\":" << row.reads[C] << "}"
+			<< ",\"writes\":{\"rust\":" << row.writes[RUST] << ",\"c\":" << row.writes[C] << "}";
+
+		if (row.patterns != nullptr) {
+			stream << ",\"patterns\":{";
+
+			for (UINT32 lang : { RUST, C }) {
+				const AccessPattern& pattern = row.patterns[lang];
+
+				stream << (lang == RUST ? "\"rust\":" : ",\"c\":");
+
+				if (pattern.Empty()) {
+					stream << "null";
+				} else {
+					stream << "{\"pattern\":\"" << PatternToString(pattern.Dominant())
+						<< "\",\"stride\":" << pattern.Stride() << "}";
+				}
+			}
+
+			stream << "}";
+		}
+
+		stream << "}";
+	}
+
+	stream << "\n]}\n";
+}
+
+template<typename T>
+static VOID WriteValue(ofstream& stream, T value) {
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// The columnar file starts with the magic "BALEEN01" and the row count (a
+// little-endian UINT64), followed by one column after another: the names
+// (a UINT32 length followed by the bytes of each), the sites (UINT64), the
+// languages (UINT8), and the Rust reads, C reads, Rust writes and C writes
+// (UINT64 each).
+static VOID WriteColumnar(ofstream& stream, const vector<ObjectRow>& rows, USIZE count) {
+	stream.write("BALEEN01", 8);
+	WriteValue<UINT64>(stream, count);
+
+	for (USIZE i = 0; i < count; i++) {
+		WriteValue<UINT32>(stream, rows[i].name->size());
+		stream.write(rows[i].name->data(), rows[i].name->size());
+	}
+
+	for (USIZE i = 0; i < count; i++) {
+		WriteValue<UINT64>(stream, rows[i].site);
+	}
+
+	for (USIZE i = 0; i < count; i++) {
+		WriteValue<UINT8>(stream, static_cast<UINT8>(rows[i].lang));
+	}
+
+	for (const UINT64* const ObjectRow::*column : { &ObjectRow::reads, &ObjectRow::writes }) {
+		for (UINT32 lang : { RUST, C }) {
+			for (USIZE i = 0; i < count; i++) {
+				WriteValue<UINT64>(stream, (rows[i].*column)[lang]);
+			}
+		}
+	}
+}
+
+VOID WriteObjects(ofstream& report, ReportFormat format, const string& directory, vector<ObjectRow>& rows, USIZE top) {
+	USIZE count = (top == 0) ? rows.size() : std::min(top, rows.size());
+
+	auto hotter = [](const ObjectRow& a, const ObjectRow& b) {
+		return a.total > b.total || (a.total == b.total && *a.name < *b.name);
+	};
+
+	// Only the rows that will be written need to be in order
+	std::partial_sort(rows.begin(), rows.begin() + count, rows.end(), hotter);
+
+	if (format == ReportFormat::TEXT) {
+		WriteText(report, rows, count);
+		return;
+	}
+
+	string path = directory;
+	std::ios::openmode mode = std::ios::out;
+
+	switch (format) {
+	case ReportFormat::CSV:
+		path += "/objects.csv";
+		break;
+	case ReportFormat::JSON:
+		path += "/objects.json";
+		break;
+	default:
+		path += "/objects.bin";
+		mode |= std::ios::binary;
+		break;
+	}
+
+	// Sites are named only for the rows that are written, and once each since
+	// most objects share theirs with others
+	vector<string> locations;
+
+	if (format != ReportFormat::COLUMNAR) {
+		map<ADDRINT, string> named;
+
+		locations.reserve(count);
+
+		for (USIZE i = 0; i < count; i++) {
+			auto location = named.find(rows[i].site);
+
+			if (location == named.end()) {
+				location = named.emplace(rows[i].site, IMG_FindOffsetByAddress(rows[i].site)).first;
+			}
+
+			locations.push_back(location->second);
+		}
+	}
+
+	vector<char> buffer(BUFFER_SIZE);
+
+	ofstream stream;
+	stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+	stream.open(path, mode);
+
+	switch (format) {
+	case ReportFormat::CSV:
+		WriteCsv(stream, rows, locations, count);
+		break;
+	case ReportFormat::JSON:
+		WriteJson(stream, rows, locations, count);
+		break;
+	default:
+		WriteColumnar(stream, rows, count);
+		break;
+	}
+
+	stream.close();
+
+	report << "Objects: " << count << " of " << rows.size() << " written to " << path << endl << endl;
+}
@@ -0,0 +1,23 @@
+#include "routine.h"
+
+RoutineTable::RoutineTable() {
+	names.push_back("?");
+}
+
+#ifndef BALEEN_NO_PIN
+UINT32 RoutineTable::Id(RTN rtn) {
+	if (!RTN_Valid(rtn)) return UNKNOWN_ROUTINE;
+
+	auto inserted = ids.emplace(RTN_Address(rtn), names.size());
+
+	if (inserted.second) {
+		names.push_back(RTN_Name(rtn));
+	}
+
+	return inserted.first->second;
+}
+#endif
+
+const string& RoutineTable::Name(UINT32 id) {
+	return id < names.size() ? names[id] : names[UNKNOWN_ROUTINE];
+}
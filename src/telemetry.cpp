@@ -0,0 +1,145 @@
+#include "telemetry.h"
+#include "registry.h"
+
+#include <algorithm>
+#include <iomanip>
+
+using std::endl;
+using std::fixed;
+using std::setprecision;
+
+static const char* ANALYSIS_LABELS[ANALYSES] = {
+	"Memory Read", "Memory Write", "malloc", "realloc", "posix_memalign", "free",
+	"mmap/munmap/mremap", "Copy", "Language Transition", "Marker", "Basic Block",
+	"Pointer Store"
+};
+
+string AnalysisToString(Analysis analysis) {
+	return ANALYSIS_LABELS[static_cast<UINT32>(analysis)];
+}
+
+Telemetry::Telemetry() : enabled(false), registry(nullptr), peakMemory(0), inlined() {
+	PIN_InitLock(&lock);
+}
+
+VOID Telemetry::Initialize() {
+	key = PIN_CreateThreadDataKey(nullptr);
+	enabled = true;
+}
+
+VOID Telemetry::AfterFork(THREADID tid) {
+	PIN_InitLock(&lock);
+
+	for (ThreadTelemetry* thread : threads) {
+		*thread = ThreadTelemetry();
+	}
+
+	images.clear();
+	peakMemory = 0;
+
+	for (UINT64& calls : inlined) {
+		calls = 0;
+	}
+}
+
+ThreadTelemetry* Telemetry::Thread(THREADID tid) {
+	ThreadTelemetry* thread = static_cast<ThreadTelemetry*>(PIN_GetThreadData(key, tid));
+
+	if (thread == nullptr) {
+		thread = new ThreadTelemetry();
+
+		PIN_SetThreadData(key, thread, tid);
+
+		PIN_GetLock(&lock, tid + 1);
+		threads.push_back(thread);
+		PIN_ReleaseLock(&lock);
+	}
+
+	return thread;
+}
+
+VOID Telemetry::AddLock(const string& tracker, LockStats& stats) {
+	stats.timed = true;
+	locks.emplace_back(tracker, &stats);
+}
+
+VOID Telemetry::AddRegistry(const RegistryStats& stats) {
+	registry = &stats;
+}
+
+VOID Telemetry::Instrumented(const string& image, UINT64 nanoseconds, UINT64 instructions) {
+	PIN_GetLock(&lock, PIN_ThreadId() + 1);
+
+	ImageTelemetry& entry = images[image];
+	entry.nanoseconds += nanoseconds;
+	entry.instructions += instructions;
+
+	PIN_ReleaseLock(&lock);
+}
+
+VOID Telemetry::SampleMemory(UINT64 bytes) {
+	PIN_GetLock(&lock, PIN_ThreadId() + 1);
+	peakMemory = std::max(peakMemory, bytes);
+	PIN_ReleaseLock(&lock);
+}
+
+VOID Telemetry::Report(ofstream& stream, UINT64 loggedBytes) {
+	if (!enabled) return;
+
+	stream << endl << "--- Overhead Report ---" << endl;
+	stream << "Peak Tool Memory:  " << peakMemory << " bytes" << endl;
+	stream << "Logged:            " << loggedBytes << " bytes" << endl;
+
+	if (registry != nullptr) {
+		std::streamsize precision = stream.precision();
+
+		stream << "Registry Lookups:  " << registry->lookups << endl;
+		stream << "Registry Misses:   " << registry->misses << endl;
+		stream << "Mean Lookup Depth: " << fixed << setprecision(2)
+			<< (registry->lookups == 0 ? 0.0 : static_cast<double>(registry->visited) / registry->lookups) << endl;
+		stream.unsetf(std::ios::floatfield);
+		stream.precision(precision);
+		stream << "Max Lookup Depth:  " << registry->deepest << endl;
+	}
+
+	UINT64 calls[ANALYSES] = {};
+
+	for (UINT32 analysis = 0; analysis < ANALYSES; analysis++) {
+		calls[analysis] = inlined[analysis];
+	}
+
+	// Counters of running threads are read without synchronization
+	for (ThreadTelemetry* thread : threads) {
+		for (UINT32 analysis = 0; analysis < ANALYSES; analysis++) {
+			calls[analysis] += thread->calls[analysis];
+		}
+	}
+
+	stream << endl << "Analysis Routine, Calls" << endl;
+
+	for (UINT32 analysis = 0; analysis < ANALYSES; analysis++) {
+		stream << ANALYSIS_LABELS[analysis] << ", " << calls[analysis] << endl;
+	}
+
+	stream << endl << "Tracker, Lock Acquisitions, Contended, Wait (cycles)" << endl;
+
+	for (const auto& entry : locks) {
+		stream << entry.first << ", "
+			<< entry.second->acquisitions << ", "
+			<< entry.second->contended << ", "
+			<< entry.second->waited << endl;
+	}
+
+	// The images that took the longest to instrument first
+	vector<pair<string, ImageTelemetry>> sorted(images.begin(), images.end());
+
+	std::sort(sorted.begin(), sorted.end(), [](const pair<string, ImageTelemetry>& a, const pair<string, ImageTelemetry>& b) {
+		return a.second.nanoseconds > b.second.nanoseconds;
+	});
+
+	stream << endl << "Image, Instrumentation Time (ns), Instructions Instrumented" << endl;
+
+	for (const auto& entry : sorted) {
+		stream << entry.first << ", " << entry.second.nanoseconds << ", " << entry.second.instructions << endl;
+	}
+}
@@ -1,5 +1,10 @@
 #include "utilities.h"
 
+#include <limits.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
 BOOL EndsWith(string_view s, string_view suffix) {
     if (s.length() < suffix.length()) return false;
     size_t start_pos = s.length() - suffix.length();
@@ -24,4 +29,70 @@ int Run(const char* command) {
     }
 
     return -1;
-}
\ No newline at end of file
+}
+
+string AbsolutePath(const string& path) {
+    if (!path.empty() && path[0] == '/') return path;
+
+    char cwd[PATH_MAX];
+
+    if (getcwd(cwd, sizeof(cwd)) == nullptr) return path;
+
+    return string(cwd) + "/" + path;
+}
+
+UINT64 MonotonicNanoseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<UINT64>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+UINT32 SizeClass(USIZE size) {
+    UINT32 sizeClass = 0;
+    USIZE limit = 16;
+
+    while (sizeClass < SIZE_CLASSES - 1 && size > limit) {
+        sizeClass += 1;
+        limit <<= 1;
+    }
+
+    return sizeClass;
+}
+
+string SizeClassToString(UINT32 sizeClass) {
+    if (sizeClass == SIZE_CLASSES - 1) {
+        return "> " + std::to_string(16ULL << (SIZE_CLASSES - 2));
+    }
+
+    return "<= " + std::to_string(16ULL << sizeClass);
+}
+
+string FilePath(INT32 fd) {
+    char path[PATH_MAX];
+    string link = "/proc/self/fd/" + std::to_string(fd);
+    ssize_t length = readlink(link.c_str(), path, sizeof(path) - 1);
+
+    if (length <= 0) return "fd " + std::to_string(fd);
+
+    return string(path, length);
+}
+
+VOID PageNodes(const vector<ADDRINT>& pages, vector<INT32>& nodes) {
+    vector<void*> addresses(pages.size());
+    vector<int> status(pages.size(), -1);
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        addresses[i] = reinterpret_cast<void*>(pages[i]);
+    }
+
+    nodes.assign(pages.size(), -1);
+
+    // move_pages only reports the node of every page when no nodes are given
+    if (pages.empty() || syscall(SYS_move_pages, 0, pages.size(), addresses.data(), nullptr, status.data(), 0) != 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        nodes[i] = status[i] >= 0 ? status[i] : -1;
+    }
+}
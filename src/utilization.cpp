@@ -0,0 +1,93 @@
+#include "utilization.h"
+
+#include <algorithm>
+
+TouchMap::TouchMap() : size(0), grain(1) {}
+
+VOID TouchMap::Resize(USIZE newSize, USIZE dropped) {
+	vector<UINT64> old;
+	USIZE oldSize = size;
+	USIZE oldGrain = grain;
+
+	old.swap(bits);
+
+	size = newSize;
+	grain = newSize <= TOUCH_BYTE_LIMIT ? 1 : CACHE_LINE_BYTES;
+
+	// Replay the old accesses, a unit at a time, in the new units
+	for (USIZE word = 0; word < old.size(); word++) {
+		for (UINT64 set = old[word]; set != 0; set &= set - 1) {
+			USIZE start = (word * 64 + __builtin_ctzll(set)) * oldGrain;
+			USIZE end = std::min(start + oldGrain, oldSize);
+
+			if (end <= dropped) continue;
+
+			start = std::max(start, dropped);
+			Touch(start - dropped, end - start);
+		}
+	}
+}
+
+VOID TouchMap::Touch(ADDRINT offset, USIZE bytes) {
+	if (offset >= size || bytes == 0) return;
+
+	if (bits.empty()) {
+		bits.resize(((size + grain - 1) / grain + 63) / 64);
+	}
+
+	USIZE last = std::min(offset + bytes, size) - 1;
+
+	for (USIZE unit = offset / grain; unit <= last / grain; unit++) {
+		bits[unit / 64] |= 1ULL << (unit % 64);
+	}
+}
+
+VOID TouchMap::Clear() {
+	bits.clear();
+}
+
+USIZE TouchMap::Untouched() const {
+	USIZE units = (size + grain - 1) / grain;
+	USIZE touched = 0;
+
+	for (UINT64 word : bits) {
+		touched += __builtin_popcountll(word) * grain;
+	}
+
+	// The last unit may reach past the end of the object
+	if (units > 0 && !bits.empty() && (bits[(units - 1) / 64] >> ((units - 1) % 64)) & 1) {
+		touched -= units * grain - size;
+	}
+
+	return size - touched;
+}
+
+VOID UtilizationGroup::Add(Language lang, const TouchMap& touched, const UINT64 reads[], const UINT64 writes[], UINT64 lateWrites) {
+	UINT64 totalReads = 0;
+	UINT64 totalWrites = 0;
+
+	for (UINT32 index = 0; index < LANGUAGES; index++) {
+		totalReads += reads[index];
+		totalWrites += writes[index];
+	}
+
+	objects += 1;
+	bytes += touched.Size();
+	untouched += touched.Untouched();
+
+	if (totalWrites > 0 && totalReads == 0) {
+		writeOnly += 1;
+		writeOnlyBytes += touched.Size();
+	}
+
+	if (totalReads > 0 && lateWrites == 0) {
+		readOnly += 1;
+		readOnlyBytes += touched.Size();
+
+		UINT32 other = static_cast<UINT32>(lang == Language::RUST ? Language::C : Language::RUST);
+
+		if (reads[other] > 0) {
+			shared += 1;
+		}
+	}
+}
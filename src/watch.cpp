@@ -0,0 +1,113 @@
+#include "watch.h"
+
+#include <fnmatch.h>
+#include <sstream>
+
+using std::endl;
+using std::istringstream;
+
+WatchList::WatchList(WatchedRanges& r) : ranges(r), watched(0), dropped(0) {
+	for (UINT32 slot = 0; slot < WATCH_SLOTS; slot++) {
+		ranges.start[slot].store(0, std::memory_order_release);
+		ranges.size[slot].store(0, std::memory_order_release);
+	}
+}
+
+VOID WatchList::SetNames(const string& list) {
+	istringstream stream(list);
+	string glob;
+
+	globs.clear();
+
+	while (std::getline(stream, glob, ',')) {
+		if (!glob.empty()) {
+			globs.push_back(glob);
+		}
+	}
+}
+
+UINT32 WatchList::Slot(const string& name) {
+	for (UINT32 slot = 0; slot < WATCH_SLOTS; slot++) {
+		if (ranges.size[slot].load(std::memory_order_relaxed) != 0 && names[slot] == name) {
+			return slot;
+		}
+	}
+
+	return WATCH_SLOTS;
+}
+
+VOID WatchList::Set(UINT32 slot, ADDRINT addr, USIZE size) {
+	ranges.size[slot].store(0, std::memory_order_release);
+	ranges.start[slot].store(addr, std::memory_order_release);
+	ranges.size[slot].store(size, std::memory_order_release);
+}
+
+VOID WatchList::Add(const string& name, ADDRINT addr, USIZE size) {
+	if (size == 0) return;
+
+	BOOL matches = false;
+
+	for (const string& glob : globs) {
+		if (fnmatch(glob.c_str(), name.c_str(), 0) == 0) {
+			matches = true;
+			break;
+		}
+	}
+
+	if (!matches) return;
+
+	// A registered range replaces an object watched under the same name
+	UINT32 slot = Slot(name);
+
+	for (UINT32 free = 0; slot == WATCH_SLOTS && free < WATCH_SLOTS; free++) {
+		if (ranges.size[free].load(std::memory_order_relaxed) == 0) {
+			slot = free;
+		}
+	}
+
+	if (slot == WATCH_SLOTS) {
+		dropped += 1;
+		return;
+	}
+
+	names[slot] = name;
+	Set(slot, addr, size);
+
+	watched += 1;
+}
+
+VOID WatchList::Move(const string& name, ADDRINT addr, USIZE size) {
+	UINT32 slot = Slot(name);
+
+	if (slot == WATCH_SLOTS) return;
+
+	Set(slot, addr, size);
+}
+
+VOID WatchList::Remove(const string& name) {
+	UINT32 slot = Slot(name);
+
+	if (slot == WATCH_SLOTS) return;
+
+	ranges.size[slot].store(0, std::memory_order_release);
+	names[slot].clear();
+}
+
+VOID WatchList::Report(ofstream& stream) {
+	if (!Enabled()) return;
+
+	stream << endl << "--- Watch Report ---" << endl;
+	stream << "Watched:    " << watched << " objects" << endl;
+	stream << "Dropped:    " << dropped << " objects (every slot was taken)" << endl;
+
+	stream << endl << "Watched at Exit, Start, Size" << endl;
+
+	for (UINT32 slot = 0; slot < WATCH_SLOTS; slot++) {
+		ADDRINT size = ranges.size[slot].load(std::memory_order_relaxed);
+
+		if (size != 0) {
+			stream << names[slot] << ", 0x" << std::hex << ranges.start[slot].load(std::memory_order_relaxed) << std::dec
+				<< ", " << size << endl;
+		}
+	}
+}
@@ -0,0 +1,407 @@
+// Compares two Baleen runs, e.g. the main branch and a pull request in CI.
+// Prints the per-language deltas in allocated bytes, accesses and FFI
+// transitions, and the objects whose accesses changed the most.
+//
+// Objects are numbered in allocation order, which changes from run to run,
+// so they are matched by name when they were named with the marker function,
+// and otherwise by allocation site and language when both runs were written
+// with -format csv. Unnamed objects without a site are compared as one group.
+// Labelled objects (nested objects of a named batch and mappings) are
+// numbered too, as 'label#N', so they are matched by label (and site and
+// language with -format csv), and every label is compared as one group.
+//
+// Every threshold is a growth in percent. When any of them is exceeded the
+// exit code is 1, so the comparison can fail a CI job.
+//
+// Usage: baleen-diff [OPTIONS] <BASELINE> <CURRENT>
+//
+// BASELINE and CURRENT are output directories or report.txt files.
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "report-reader.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::ifstream;
+using std::map;
+using std::setprecision;
+using std::string;
+using std::vector;
+
+static const int LANGUAGES = 2;
+static const char* LANGUAGE_NAMES[LANGUAGES] = { "Rust", "C" };
+
+// The name of the group of unnamed objects that could not be matched.
+static const char* UNNAMED = "(unnamed objects)";
+
+struct ObjectCounts {
+	uint64_t reads[LANGUAGES];
+	uint64_t writes[LANGUAGES];
+
+	uint64_t Total() const {
+		uint64_t total = 0;
+
+		for (int lang = 0; lang < LANGUAGES; lang++) {
+			total += reads[lang] + writes[lang];
+		}
+
+		return total;
+	}
+};
+
+struct Run {
+	uint64_t allocated[LANGUAGES];
+	uint64_t reads[LANGUAGES];
+	uint64_t writes[LANGUAGES];
+
+	// Transitions into each language.
+	uint64_t transitions[LANGUAGES];
+
+	// Maps the name, or site and language, of every object to its accesses.
+	map<string, ObjectCounts> objects;
+};
+
+struct Thresholds {
+	// A negative threshold is not checked.
+	double allocated = -1;
+	double accesses = -1;
+	double transitions = -1;
+	double object = -1;
+
+	// Changes below this many bytes or accesses are never regressions.
+	uint64_t minimum = 0;
+};
+
+static bool IsNumber(const string& s) {
+	return !s.empty() && s.find_first_not_of("0123456789") == string::npos;
+}
+
+// The label of an object named 'label#N', or an empty string for every other
+// name.
+static string Label(const string& name) {
+	size_t hash = name.rfind('#');
+
+	if (hash == string::npos || hash == 0 || !IsNumber(name.substr(hash + 1))) return "";
+
+	return name.substr(0, hash);
+}
+
+static uint64_t Value(const ReportSection* section, const string& label) {
+	if (section == nullptr) return 0;
+
+	for (const ReportValue& value : section->values) {
+		if (value.label == label) return value.number;
+	}
+
+	return 0;
+}
+
+// Splits a line of objects.csv, whose names are quoted when needed.
+static vector<string> SplitCsv(const string& line) {
+	vector<string> fields(1);
+	bool quoted = false;
+
+	for (size_t i = 0; i < line.size(); i++) {
+		char c = line[i];
+
+		if (quoted) {
+			if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+				fields.back() += '"';
+				i += 1;
+			} else if (c == '"') {
+				quoted = false;
+			} else {
+				fields.back() += c;
+			}
+		} else if (c == '"') {
+			quoted = true;
+		} else if (c == ',') {
+			fields.push_back("");
+		} else {
+			fields.back() += c;
+		}
+	}
+
+	return fields;
+}
+
+static void AddObject(Run& run, const string& key, const uint64_t reads[], const uint64_t writes[]) {
+	ObjectCounts& counts = run.objects[key];
+
+	for (int lang = 0; lang < LANGUAGES; lang++) {
+		counts.reads[lang] += reads[lang];
+		counts.writes[lang] += writes[lang];
+	}
+}
+
+// Reads objects.csv (name, site, language and counts). Sites are relative to
+// their image (e.g. 'libfoo.so+0x1a2b'), so unnamed objects match across runs
+// even with ASLR. Returns false if there is none.
+static bool ReadObjectsCsv(const string& path, Run& run) {
+	ifstream input(path);
+
+	if (!input.is_open()) return false;
+
+	string line;
+	std::getline(input, line);
+
+	while (std::getline(input, line)) {
+		vector<string> fields = SplitCsv(line);
+
+		if (fields.size() < 7) continue;
+
+		uint64_t reads[LANGUAGES] = { std::strtoull(fields[3].c_str(), nullptr, 10), std::strtoull(fields[4].c_str(), nullptr, 10) };
+		uint64_t writes[LANGUAGES] = { std::strtoull(fields[5].c_str(), nullptr, 10), std::strtoull(fields[6].c_str(), nullptr, 10) };
+
+		string label = Label(fields[0]);
+		string key = fields[0];
+
+		if (IsNumber(fields[0])) {
+			key = fields[1] + " (" + fields[2] + ")";
+		} else if (!label.empty()) {
+			key = label + " at " + fields[1] + " (" + fields[2] + ")";
+		}
+
+		AddObject(run, key, reads, writes);
+	}
+
+	return true;
+}
+
+// Reads the object table of report.txt, which has no sites.
+static void ReadObjectTable(const Report& report, Run& run) {
+	const ReportSection* section = report.Find("Object Report");
+
+	if (section == nullptr || section->tables.empty()) return;
+
+	for (const vector<string>& row : section->tables[0].rows) {
+		if (row.size() < 5) continue;
+
+		uint64_t reads[LANGUAGES] = { std::strtoull(row[1].c_str(), nullptr, 10), std::strtoull(row[2].c_str(), nullptr, 10) };
+		uint64_t writes[LANGUAGES] = { std::strtoull(row[3].c_str(), nullptr, 10), std::strtoull(row[4].c_str(), nullptr, 10) };
+
+		string label = Label(row[0]);
+
+		AddObject(run, IsNumber(row[0]) ? UNNAMED : label.empty() ? row[0] : label, reads, writes);
+	}
+}
+
+static bool ReadRun(const string& path, Run& run) {
+	struct stat info;
+
+	if (stat(path.c_str(), &info) != 0) {
+		cerr << "Cannot find " << path << endl;
+		return false;
+	}
+
+	string directory = S_ISDIR(info.st_mode) ? path : path.substr(0, path.rfind('/') + 1);
+	string file = S_ISDIR(info.st_mode) ? path + "/report.txt" : path;
+
+	if (directory.empty()) directory = ".";
+
+	Report report;
+
+	if (!ReadReport(file, report)) {
+		cerr << "Cannot read " << file << endl;
+		return false;
+	}
+
+	const ReportSection* allocation = report.Find("Allocation Report");
+	const ReportSection* accesses = report.Find("Access Report");
+	const ReportSection* language = report.Find("Language Report");
+
+	for (int lang = 0; lang < LANGUAGES; lang++) {
+		string name = LANGUAGE_NAMES[lang];
+
+		run.allocated[lang] = Value(allocation, name);
+		run.reads[lang] = Value(accesses, "Reads (" + name + ")");
+		run.writes[lang] = Value(accesses, "Writes (" + name + ")");
+	}
+
+	run.transitions[1] = Value(language, "Transitions (Rust to C)");
+	run.transitions[0] = Value(language, "Transitions (C to Rust)");
+
+	if (!ReadObjectsCsv(directory + "/objects.csv", run)) {
+		ReadObjectTable(report, run);
+	}
+
+	return true;
+}
+
+static double Growth(uint64_t baseline, uint64_t current) {
+	if (baseline == 0) return current == 0 ? 0.0 : INFINITY;
+
+	return 100.0 * (static_cast<double>(current) - static_cast<double>(baseline)) / baseline;
+}
+
+// Prints a row and returns whether it is a regression.
+static bool Compare(const string& name, uint64_t baseline, uint64_t current, double threshold, uint64_t minimum) {
+	double growth = Growth(baseline, current);
+	int64_t delta = static_cast<int64_t>(current) - static_cast<int64_t>(baseline);
+
+	bool regressed = threshold >= 0 && delta > 0 && static_cast<uint64_t>(delta) >= minimum && growth > threshold;
+
+	cout << name << ", " << baseline << ", " << current << ", "
+		<< (delta > 0 ? "+" : "") << delta << ", ";
+
+	if (std::isinf(growth)) {
+		cout << "new";
+	} else {
+		cout << (growth > 0 ? "+" : "") << growth << "%";
+	}
+
+	cout << (regressed ? ", REGRESSION" : "") << endl;
+
+	return regressed;
+}
+
+static bool ParseThreshold(const char* value, double& threshold) {
+	char* end;
+	threshold = std::strtod(value, &end);
+
+	return *end == '\0' && threshold >= 0;
+}
+
+static int Usage(const char* program) {
+	cerr << "Usage: " << program << " [OPTIONS] <BASELINE> <CURRENT>" << endl
+		<< endl
+		<< "BASELINE and CURRENT are Baleen output directories or report.txt files." << endl
+		<< endl
+		<< "Options (thresholds are growths in percent):" << endl
+		<< "  --max-allocated <PERCENT>    allocated bytes of any language" << endl
+		<< "  --max-accesses <PERCENT>     reads plus writes made by any language" << endl
+		<< "  --max-transitions <PERCENT>  FFI transitions into any language" << endl
+		<< "  --max-object <PERCENT>       accesses to any single object" << endl
+		<< "  --min-change <N>             ignore changes smaller than N bytes or accesses" << endl
+		<< "  --objects <N>                number of changed objects to show (default 20)" << endl;
+
+	return 2;
+}
+
+int main(int argc, char *argv[]) {
+	Thresholds thresholds;
+	size_t shown = 20;
+	vector<string> paths;
+
+	for (int i = 1; i < argc; i++) {
+		string option = argv[i];
+
+		if (option.compare(0, 2, "--") != 0) {
+			paths.push_back(option);
+			continue;
+		}
+
+		if (i + 1 >= argc) return Usage(argv[0]);
+
+		const char* value = argv[++i];
+		bool valid = true;
+
+		if (option == "--max-allocated") {
+			valid = ParseThreshold(value, thresholds.allocated);
+		} else if (option == "--max-accesses") {
+			valid = ParseThreshold(value, thresholds.accesses);
+		} else if (option == "--max-transitions") {
+			valid = ParseThreshold(value, thresholds.transitions);
+		} else if (option == "--max-object") {
+			valid = ParseThreshold(value, thresholds.object);
+		} else if (option == "--min-change" && IsNumber(value)) {
+			thresholds.minimum = std::strtoull(value, nullptr, 10);
+		} else if (option == "--objects" && IsNumber(value)) {
+			shown = std::strtoull(value, nullptr, 10);
+		} else {
+			valid = false;
+		}
+
+		if (!valid) return Usage(argv[0]);
+	}
+
+	if (paths.size() != 2) return Usage(argv[0]);
+
+	Run baseline = {}, current = {};
+
+	if (!ReadRun(paths[0], baseline) || !ReadRun(paths[1], current)) return 2;
+
+	bool regressed = false;
+
+	cout << fixed << setprecision(2);
+
+	cout << "--- Allocation Delta ---" << endl;
+	cout << "Language, Baseline (bytes), Current (bytes), Delta, Delta (%)" << endl;
+
+	for (int lang = 0; lang < LANGUAGES; lang++) {
+		regressed |= Compare(LANGUAGE_NAMES[lang], baseline.allocated[lang], current.allocated[lang], thresholds.allocated, thresholds.minimum);
+	}
+
+	cout << endl << "--- Access Delta ---" << endl;
+	cout << "Language, Baseline, Current, Delta, Delta (%)" << endl;
+
+	for (int lang = 0; lang < LANGUAGES; lang++) {
+		regressed |= Compare(LANGUAGE_NAMES[lang],
+			baseline.reads[lang] + baseline.writes[lang],
+			current.reads[lang] + current.writes[lang],
+			thresholds.accesses, thresholds.minimum);
+	}
+
+	cout << endl << "--- Transition Delta ---" << endl;
+	cout << "Into, Baseline, Current, Delta, Delta (%)" << endl;
+
+	for (int lang = 0; lang < LANGUAGES; lang++) {
+		regressed |= Compare(LANGUAGE_NAMES[lang], baseline.transitions[lang], current.transitions[lang], thresholds.transitions, thresholds.minimum);
+	}
+
+	// Every object of either run, with the biggest changes first
+	vector<string> names;
+
+	for (const auto& entry : baseline.objects) names.push_back(entry.first);
+
+	for (const auto& entry : current.objects) {
+		if (baseline.objects.count(entry.first) == 0) names.push_back(entry.first);
+	}
+
+	auto change = [&](const string& name) {
+		int64_t before = static_cast<int64_t>(baseline.objects[name].Total());
+		int64_t after = static_cast<int64_t>(current.objects[name].Total());
+		return std::llabs(after - before);
+	};
+
+	std::stable_sort(names.begin(), names.end(), [&](const string& a, const string& b) {
+		return change(a) > change(b);
+	});
+
+	cout << endl << "--- Object Delta ---" << endl;
+	cout << "Object, Baseline, Current, Delta, Delta (%)" << endl;
+
+	for (size_t i = 0; i < names.size(); i++) {
+		uint64_t before = baseline.objects[names[i]].Total();
+		uint64_t after = current.objects[names[i]].Total();
+
+		if (before == after) break;
+
+		// Objects past the shown ones are still checked
+		if (i < shown) {
+			regressed |= Compare(names[i], before, after, thresholds.object, thresholds.minimum);
+		} else {
+			int64_t delta = static_cast<int64_t>(after) - static_cast<int64_t>(before);
+			regressed |= thresholds.object >= 0 && delta > 0 && static_cast<uint64_t>(delta) >= thresholds.minimum
+				&& Growth(before, after) > thresholds.object;
+		}
+	}
+
+	cout << endl << (regressed ? "Regressions found" : "No regressions") << endl;
+
+	return regressed ? 1 : 0;
+}
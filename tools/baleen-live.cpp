@@ -0,0 +1,100 @@
+// Polls the live counters a running Baleen publishes with -live and prints
+// them until the program exits.
+//
+// Usage: baleen-live <PID> [INTERVAL (ms)]
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "live.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+static void Print(const LiveCounters& counters) {
+	cout << "--- Baleen (PID " << counters.pid << ") at " << counters.updated / 1000000 << " ms"
+		<< (counters.finished ? ", finished" : "") << " ---" << endl;
+
+	cout << "Language, Allocated (bytes), Live (bytes), Peak (bytes), Reads, Writes" << endl;
+
+	const char* names[LIVE_LANGUAGES] = { "Rust", "C" };
+
+	for (int lang = 0; lang < LIVE_LANGUAGES; lang++) {
+		cout << names[lang] << ", "
+			<< counters.allocated[lang] << ", "
+			<< counters.live[lang] << ", "
+			<< counters.peak[lang] << ", "
+			<< counters.reads[lang] << ", "
+			<< counters.writes[lang] << endl;
+	}
+
+	cout << "FFI transitions: " << counters.transitions
+		<< " (" << counters.transitionRate << "/s)" << endl;
+
+	cout << "Name, Reads (Rust), Reads (C), Writes (Rust), Writes (C)" << endl;
+
+	for (uint32_t i = 0; i < counters.objectCount && i < LIVE_TOP_OBJECTS; i++) {
+		const LiveObject& object = counters.objects[i];
+
+		cout << object.name << ", "
+			<< object.reads[LIVE_RUST] << ", "
+			<< object.reads[LIVE_C] << ", "
+			<< object.writes[LIVE_RUST] << ", "
+			<< object.writes[LIVE_C] << endl;
+	}
+
+	cout << endl;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		cerr << "Usage: " << argv[0] << " <PID> [INTERVAL (ms)]" << endl;
+		return 2;
+	}
+
+	string name = string(LIVE_SEGMENT_PREFIX) + argv[1];
+	int interval = argc > 2 ? atoi(argv[2]) : 1000;
+
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+	if (fd < 0) {
+		cerr << "No live counters for PID " << argv[1] << ", was Baleen started with -live?" << endl;
+		return 1;
+	}
+
+	void* memory = mmap(nullptr, sizeof(LiveCounters), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (memory == MAP_FAILED) {
+		cerr << "Failed to map " << name << endl;
+		return 1;
+	}
+
+	const LiveCounters* counters = static_cast<const LiveCounters*>(memory);
+
+	if (counters->magic != LIVE_MAGIC || counters->version != LIVE_VERSION) {
+		cerr << name << " is not a Baleen live counter segment this reader understands" << endl;
+		return 1;
+	}
+
+	LiveCounters snapshot;
+
+	do {
+		LiveRead(counters, &snapshot);
+		Print(snapshot);
+
+		usleep(interval * 1000);
+	} while (!snapshot.finished);
+
+	munmap(memory, sizeof(LiveCounters));
+
+	return 0;
+}
@@ -0,0 +1,278 @@
+// Combines the reports of a multi-process run into one. The first process
+// writes to the output directory itself and every child it followed to a
+// directory named after its PID inside it.
+//
+// Values (e.g. allocated bytes) are summed over all processes, except peaks
+// and maxima (e.g. "Peak (Rust)" or "Max Lookup Depth"), which keep the
+// largest value of any process, and means, which cannot be recombined from
+// the reports and keep the largest one too. Tables are concatenated with a
+// leading Process column, and the object table is sorted by total accesses. The result is written to DIRECTORY/merged-report.txt,
+// and the per-process objects.csv files (if any) to DIRECTORY/merged-objects.csv.
+//
+// Usage: baleen-merge [DIRECTORY]
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "report-reader.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+// The name of the first process, which has no directory of its own.
+static const char* MAIN_PROCESS = "main";
+
+struct Process {
+	string name;
+	string directory;
+	Report report;
+};
+
+static bool IsNumber(const string& s) {
+	return !s.empty() && s.find_first_not_of("0123456789") == string::npos;
+}
+
+static vector<Process> FindProcesses(const string& root) {
+	vector<Process> processes;
+
+	Process main;
+	main.name = MAIN_PROCESS;
+	main.directory = root;
+
+	if (ReadReport(root + "/report.txt", main.report)) {
+		processes.push_back(main);
+	}
+
+	DIR* dir = opendir(root.c_str());
+
+	if (dir == nullptr) return processes;
+
+	vector<string> children;
+
+	while (struct dirent* entry = readdir(dir)) {
+		if (IsNumber(entry->d_name)) {
+			children.push_back(entry->d_name);
+		}
+	}
+
+	closedir(dir);
+
+	std::sort(children.begin(), children.end(), [](const string& a, const string& b) {
+		return std::stoull(a) < std::stoull(b);
+	});
+
+	for (const string& child : children) {
+		Process process;
+		process.name = child;
+		process.directory = root + "/" + child;
+
+		// Children that are still running (or crashed) have no report yet
+		if (ReadReport(process.directory + "/report.txt", process.report)) {
+			processes.push_back(process);
+		} else {
+			cerr << "Skipping process " << child << ", it has no report" << endl;
+		}
+	}
+
+	return processes;
+}
+
+// Whether the value called `label` is merged with std::max instead of summed.
+static bool IsMaximum(const string& label) {
+	for (const char* prefix : { "Peak", "Max", "Mean" }) {
+		if (label.rfind(prefix, 0) == 0) return true;
+	}
+
+	return false;
+}
+
+static uint64_t SumCells(const vector<string>& row, size_t first, size_t last) {
+	uint64_t total = 0;
+
+	for (size_t i = first; i <= last && i < row.size(); i++) {
+		total += std::strtoull(row[i].c_str(), nullptr, 10);
+	}
+
+	return total;
+}
+
+static void MergeSection(ofstream& output, const string& title, const vector<Process>& processes) {
+	// Merge the values by label, keeping the order of the first report
+	vector<ReportValue> values;
+	vector<string> text;
+
+	// Every table is identified by its position in the section
+	vector<ReportTable> tables;
+
+	for (const Process& process : processes) {
+		const ReportSection* section = process.report.Find(title);
+
+		if (section == nullptr) continue;
+
+		for (const ReportValue& value : section->values) {
+			auto it = std::find_if(values.begin(), values.end(), [&](const ReportValue& v) {
+				return v.label == value.label;
+			});
+
+			if (it == values.end()) {
+				values.push_back(value);
+			} else if (IsMaximum(value.label)) {
+				it->number = std::max(it->number, value.number);
+			} else {
+				it->number += value.number;
+			}
+		}
+
+		for (const string& line : section->text) {
+			if (std::find(text.begin(), text.end(), line) == text.end()) {
+				text.push_back(line);
+			}
+		}
+
+		for (size_t i = 0; i < section->tables.size(); i++) {
+			const ReportTable& table = section->tables[i];
+
+			if (tables.size() <= i) {
+				ReportTable merged;
+				merged.header.push_back("Process");
+				merged.header.insert(merged.header.end(), table.header.begin(), table.header.end());
+				tables.push_back(merged);
+			}
+
+			for (const vector<string>& row : table.rows) {
+				vector<string> merged;
+				merged.push_back(process.name);
+				merged.insert(merged.end(), row.begin(), row.end());
+				tables[i].rows.push_back(merged);
+			}
+		}
+	}
+
+	// The hottest objects of all processes come first, by the sum of their
+	// four read and write columns (after Process and Name)
+	if (title == "Object Report") {
+		for (ReportTable& table : tables) {
+			std::stable_sort(table.rows.begin(), table.rows.end(), [](const vector<string>& a, const vector<string>& b) {
+				return SumCells(a, 2, 5) > SumCells(b, 2, 5);
+			});
+		}
+	}
+
+	if (!title.empty()) {
+		output << "--- " << title << " ---" << endl;
+	}
+
+	for (const string& line : text) {
+		output << line << endl;
+	}
+
+	for (const ReportValue& value : values) {
+		output << value.label << ": " << value.number;
+
+		if (!value.unit.empty()) {
+			output << " " << value.unit;
+		}
+
+		output << endl;
+	}
+
+	for (const ReportTable& table : tables) {
+		if (!values.empty() || !text.empty() || &table != &tables.front()) {
+			output << endl;
+		}
+
+		for (size_t i = 0; i < table.header.size(); i++) {
+			output << (i > 0 ? ", " : "") << table.header[i];
+		}
+
+		output << endl;
+
+		for (const vector<string>& row : table.rows) {
+			for (size_t i = 0; i < row.size(); i++) {
+				output << (i > 0 ? ", " : "") << row[i];
+			}
+
+			output << endl;
+		}
+	}
+
+	output << endl;
+}
+
+static void MergeObjects(const string& root, const vector<Process>& processes) {
+	ofstream output;
+	bool header = false;
+
+	for (const Process& process : processes) {
+		ifstream input(process.directory + "/objects.csv");
+
+		if (!input.is_open()) continue;
+
+		string line;
+
+		if (!std::getline(input, line)) continue;
+
+		if (!header) {
+			output.open(root + "/merged-objects.csv");
+			output << "Process," << line << '\n';
+			header = true;
+		}
+
+		while (std::getline(input, line)) {
+			output << process.name << "," << line << '\n';
+		}
+	}
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 2) {
+		cerr << "Usage: " << argv[0] << " [DIRECTORY]" << endl;
+		return 2;
+	}
+
+	string root = argc > 1 ? argv[1] : ".baleen";
+	vector<Process> processes = FindProcesses(root);
+
+	if (processes.empty()) {
+		cerr << "No reports in " << root << endl;
+		return 1;
+	}
+
+	// Sections appear in the order the processes first wrote them
+	vector<string> titles;
+
+	for (const Process& process : processes) {
+		for (const ReportSection& section : process.report.sections) {
+			if (std::find(titles.begin(), titles.end(), section.title) == titles.end()) {
+				titles.push_back(section.title);
+			}
+		}
+	}
+
+	ofstream output(root + "/merged-report.txt");
+
+	output << "--- Processes ---" << endl;
+	output << "Processes: " << processes.size() << endl;
+	output << endl;
+
+	for (const string& title : titles) {
+		MergeSection(output, title, processes);
+	}
+
+	MergeObjects(root, processes);
+
+	cout << "Merged " << processes.size() << " reports into " << root << "/merged-report.txt" << endl;
+
+	return 0;
+}
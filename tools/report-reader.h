@@ -0,0 +1,149 @@
+// Reads the report.txt that Baleen writes, for the utilities that combine or
+// compare reports. Pin-free, like the utilities themselves.
+//
+// A report is a list of sections, each starting with a "--- Title ---" line.
+// Sections hold values ("Label: 42 bytes"), tables (a header line and the
+// comma-separated rows below it, up to the next blank line) and free text.
+
+#ifndef REPORT_READER_H
+#define REPORT_READER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A "Label: 42 bytes" line, split into "Label", 42 and "bytes".
+struct ReportValue {
+	std::string label;
+	uint64_t number;
+	std::string unit;
+};
+
+struct ReportTable {
+	std::vector<std::string> header;
+	std::vector<std::vector<std::string>> rows;
+};
+
+struct ReportSection {
+	std::string title;
+	std::vector<ReportValue> values;
+	std::vector<ReportTable> tables;
+
+	// Lines that are neither values nor tables, e.g. explanations.
+	std::vector<std::string> text;
+};
+
+struct Report {
+	std::vector<ReportSection> sections;
+
+	// Returns the section called `title`, or nullptr if there is none.
+	const ReportSection* Find(const std::string& title) const {
+		for (const ReportSection& section : sections) {
+			if (section.title == title) return &section;
+		}
+
+		return nullptr;
+	}
+};
+
+static inline std::vector<std::string> SplitCells(const std::string& line, size_t columns) {
+	std::vector<std::string> cells;
+	size_t begin = 0;
+
+	while (true) {
+		size_t end = line.find(", ", begin);
+
+		if (end == std::string::npos) {
+			cells.push_back(line.substr(begin));
+			break;
+		}
+
+		cells.push_back(line.substr(begin, end - begin));
+		begin = end + 2;
+	}
+
+	// Names (the first column) may contain the separator themselves
+	while (columns > 0 && cells.size() > columns) {
+		cells[0] += ", " + cells[1];
+		cells.erase(cells.begin() + 1);
+	}
+
+	return cells;
+}
+
+// Parses "Label: 42 rest" lines whose value is a single number.
+static inline bool ParseValue(const std::string& line, ReportValue& value) {
+	size_t colon = line.find(':');
+
+	if (colon == std::string::npos || line.find(", ") != std::string::npos) return false;
+
+	size_t start = line.find_first_not_of(' ', colon + 1);
+
+	if (start == std::string::npos || line[start] < '0' || line[start] > '9') return false;
+
+	char* end;
+	value.number = std::strtoull(line.c_str() + start, &end, 10);
+	value.label = line.substr(0, colon);
+
+	std::string unit = end;
+	size_t first = unit.find_first_not_of(' ');
+	value.unit = first == std::string::npos ? "" : unit.substr(first);
+
+	// "3 (1024 bytes)" is not a single number
+	return value.unit.find_first_of("0123456789") == std::string::npos;
+}
+
+// Reads the report at `path` into `report`. Returns false if it can't be read.
+static inline bool ReadReport(const std::string& path, Report& report) {
+	std::ifstream input(path);
+
+	if (!input.is_open()) return false;
+
+	std::string line;
+	ReportTable* table = nullptr;
+
+	while (std::getline(input, line)) {
+		if (line.empty()) {
+			table = nullptr;
+			continue;
+		}
+
+		if (line.size() > 8 && line.compare(0, 4, "--- ") == 0 && line.compare(line.size() - 4, 4, " ---") == 0) {
+			ReportSection section;
+			section.title = line.substr(4, line.size() - 8);
+			report.sections.push_back(section);
+			table = nullptr;
+			continue;
+		}
+
+		// Lines before the first title belong to an untitled section
+		if (report.sections.empty()) {
+			report.sections.push_back(ReportSection());
+		}
+
+		ReportSection& section = report.sections.back();
+
+		if (table != nullptr) {
+			table->rows.push_back(SplitCells(line, table->header.size()));
+			continue;
+		}
+
+		ReportValue value;
+
+		if (ParseValue(line, value)) {
+			section.values.push_back(value);
+		} else if (line.find(", ") != std::string::npos) {
+			section.tables.push_back(ReportTable());
+			table = &section.tables.back();
+			table->header = SplitCells(line, 0);
+		} else {
+			section.text.push_back(line);
+		}
+	}
+
+	return true;
+}
+
+#endif // REPORT_READER_H